@@ -346,8 +346,8 @@ pub mod ffi {
 
         fn evm_try_flush_db(result: &mut CrossBoundaryResult);
 
-        fn ocean_index_block(result: &mut CrossBoundaryResult, block_str: String);
-        fn ocean_invalidate_block(result: &mut CrossBoundaryResult, block: String);
+        fn ocean_index_block(result: &mut CrossBoundaryResult, block_str: &str);
+        fn ocean_invalidate_block(result: &mut CrossBoundaryResult, block_str: &str);
 
         fn ocean_try_set_tx_result(
             result: &mut CrossBoundaryResult,
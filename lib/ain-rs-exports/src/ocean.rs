@@ -8,14 +8,14 @@ use crate::{
 };
 
 #[ffi_fallible]
-pub fn ocean_index_block(block_str: String) -> Result<()> {
-    let block: Block<Transaction> = serde_json::from_str(&block_str)?;
+pub fn ocean_index_block(block_str: &str) -> Result<()> {
+    let block: Block<Transaction> = serde_json::from_str(block_str)?;
     ain_ocean::index_block(&ain_ocean::SERVICES, block)
 }
 
 #[ffi_fallible]
-pub fn ocean_invalidate_block(block_str: String) -> Result<()> {
-    let block: Block<Transaction> = serde_json::from_str(&block_str)?;
+pub fn ocean_invalidate_block(block_str: &str) -> Result<()> {
+    let block: Block<Transaction> = serde_json::from_str(block_str)?;
     ain_ocean::invalidate_block(&ain_ocean::SERVICES, block)
 }
 
@@ -0,0 +1,109 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <kvmap.h>
+#include <random.h>
+
+#include <vector>
+
+// Mimics the shape of the keys a block writes to the custom view: mostly
+// prefixed balance keys, followed by undo, history and a few long keys.
+static std::vector<TBytes> GenerateKeys(size_t count)
+{
+    FastRandomContext rng(true);
+    std::vector<TBytes> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        size_t size;
+        const auto kind = rng.randrange(100);
+        if (kind < 70) {
+            size = 1 + 1 + (rng.randbool() ? 22 : 25) + 4; // balance: prefix, script, token id
+        } else if (kind < 85) {
+            size = 1 + 4 + 32; // undo: prefix, height, txid
+        } else if (kind < 95) {
+            size = 1 + 26 + 4 + 4; // history: prefix, script, height, txn
+        } else {
+            size = 1 + 64; // gov variables, oracle and vault keys
+        }
+        keys.push_back(rng.randbytes(size));
+        keys.back()[0] = static_cast<unsigned char>(kind % 8);
+    }
+    return keys;
+}
+
+static void Assign(MapKV& map, const TBytes& key, const TBytes& value)
+{
+    map[key] = value;
+}
+
+static void Assign(ArenaMapKV& map, const TBytes& key, const TBytes& value)
+{
+    auto it = map.lower_bound(key);
+    if (it != map.end() && CompareKeyBytes(key, it->first) == 0) {
+        it->second = value;
+    } else {
+        map.emplace_hint(it, ToKeyBytes(key), value);
+    }
+}
+
+// Block view: every key is written twice, read back and the set is then
+// iterated in order as Flush does.
+template <typename Map>
+static void BlockDirtySet(benchmark::State& state)
+{
+    const auto keys = GenerateKeys(5000);
+    const TBytes value(40, 0x55);
+    while (state.KeepRunning()) {
+        Map map;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (const auto& key : keys) {
+                Assign(map, key, value);
+            }
+        }
+        size_t found = 0;
+        for (const auto& key : keys) {
+            found += map.find(key) != map.end();
+        }
+        size_t total = 0;
+        for (const auto& [key, val] : map) {
+            total += key.size() + (val ? val->size() : 0);
+        }
+        assert(found == keys.size() && total > 0);
+    }
+}
+
+// Nested views: short-lived per-transaction sets of a few keys each,
+// merged into the block set one after another.
+template <typename Map>
+static void NestedDirtySets(benchmark::State& state)
+{
+    const auto keys = GenerateKeys(5000);
+    const TBytes value(40, 0x55);
+    TBytes flushKey;
+    while (state.KeepRunning()) {
+        Map block;
+        for (size_t tx = 0; tx + 10 <= keys.size(); tx += 10) {
+            Map txMap;
+            for (size_t i = tx; i < tx + 10; ++i) {
+                Assign(txMap, keys[i], value);
+            }
+            for (const auto& [key, val] : txMap) {
+                flushKey.assign(key.begin(), key.end());
+                Assign(block, flushKey, *val);
+            }
+        }
+        assert(!block.empty());
+    }
+}
+
+static void DirtySetBlockMapKV(benchmark::State& state) { BlockDirtySet<MapKV>(state); }
+static void DirtySetBlockArenaMapKV(benchmark::State& state) { BlockDirtySet<ArenaMapKV>(state); }
+static void DirtySetNestedMapKV(benchmark::State& state) { NestedDirtySets<MapKV>(state); }
+static void DirtySetNestedArenaMapKV(benchmark::State& state) { NestedDirtySets<ArenaMapKV>(state); }
+
+BENCHMARK(DirtySetBlockMapKV, 50);
+BENCHMARK(DirtySetBlockArenaMapKV, 50);
+BENCHMARK(DirtySetNestedMapKV, 50);
+BENCHMARK(DirtySetNestedArenaMapKV, 50);
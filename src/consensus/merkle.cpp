@@ -61,6 +61,15 @@ uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated) {
     return hashes[0];
 }
 
+void ReduceMerkleLevels(std::vector<uint256>& hashes, unsigned int levels) {
+    for (; levels && !hashes.empty(); --levels) {
+        if (hashes.size() & 1) {
+            hashes.push_back(hashes.back());
+        }
+        SHA256D64(hashes[0].begin(), hashes[0].begin(), hashes.size() / 2);
+        hashes.resize(hashes.size() / 2);
+    }
+}
 
 uint256 BlockMerkleRoot(const CBlock& block, bool* mutated)
 {
@@ -14,6 +14,14 @@
 
 uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated = nullptr);
 
+/*
+ * Reduce the hashes by the given number of tree levels, duplicating the
+ * last hash of odd levels as ComputeMerkleRoot does. The roots of aligned
+ * chunks of 2^levels leaves are the nodes of the full tree at that level,
+ * so chunks can be reduced independently.
+ */
+void ReduceMerkleLevels(std::vector<uint256>& hashes, unsigned int levels);
+
 /*
  * Compute the Merkle root of the transactions in a block.
  * *mutated is set to true if a duplicated subtree was found.
@@ -253,6 +253,42 @@ void CDBIterator::SeekToFirst() { piter->SeekToFirst(); }
 void CDBIterator::Next() { piter->Next(); }
 void CDBIterator::Prev() { piter->Prev(); }
 
+Span<const unsigned char> CDBIterator::GetValueRaw(std::vector<unsigned char>& buffer) const
+{
+    leveldb::Slice slValue = piter->value();
+    const auto data = reinterpret_cast<const unsigned char*>(slValue.data());
+    const auto& obfuscate_key = dbwrapper_private::GetObfuscateKey(parent);
+    if (std::all_of(obfuscate_key.begin(), obfuscate_key.end(), [](unsigned char c) { return c == 0; })) {
+        return {data, static_cast<std::ptrdiff_t>(slValue.size())};
+    }
+    buffer.assign(data, data + slValue.size());
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        buffer[i] ^= obfuscate_key[i % obfuscate_key.size()];
+    }
+    return MakeSpan(buffer);
+}
+
+bool CDBWrapper::ReadRaw(Span<const unsigned char> key, std::vector<unsigned char>& value, const leveldb::ReadOptions& otherOptions) const
+{
+    leveldb::Slice slKey(reinterpret_cast<const char*>(key.data()), key.size());
+
+    std::string strValue;
+    leveldb::Status status = pdb->Get(otherOptions, slKey, &strValue);
+    if (!status.ok()) {
+        if (status.IsNotFound())
+            return false;
+        LogPrintf("LevelDB read failure: %s\n", status.ToString());
+        dbwrapper_private::HandleError(status);
+    }
+    value.assign(strValue.begin(), strValue.end());
+    if (!obfuscate_key.empty()) {
+        for (size_t i = 0; i < value.size(); ++i) {
+            value[i] ^= obfuscate_key[i % obfuscate_key.size()];
+        }
+    }
+    return true;
+}
+
 namespace dbwrapper_private {
 
 void HandleError(const leveldb::Status& status)
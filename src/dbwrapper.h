@@ -8,6 +8,7 @@
 #include <clientversion.h>
 #include <fs.h>
 #include <serialize.h>
+#include <span.h>
 #include <streams.h>
 #include <util/system.h>
 #include <util/strencodings.h>
@@ -193,6 +194,21 @@ public:
         return piter->value().size();
     }
 
+    /** Seeks to an already serialized key, see GetKeyRaw() */
+    void SeekRaw(Span<const unsigned char> key) {
+        piter->Seek(leveldb::Slice(reinterpret_cast<const char*>(key.data()), key.size()));
+    }
+
+    /** Serialized key borrowed from LevelDB, only valid until the iterator is moved */
+    Span<const unsigned char> GetKeyRaw() const {
+        leveldb::Slice slKey = piter->key();
+        return {reinterpret_cast<const unsigned char*>(slKey.data()), static_cast<std::ptrdiff_t>(slKey.size())};
+    }
+
+    /** Serialized value, borrowed from LevelDB like GetKeyRaw() unless the database
+     *  is obfuscated, in which case it is de-obfuscated into buffer */
+    Span<const unsigned char> GetValueRaw(std::vector<unsigned char>& buffer) const;
+
 };
 
 //template<>
@@ -295,6 +311,14 @@ public:
         return true;
     }
 
+    /** Reads an already serialized key, see CDBIterator::GetKeyRaw(). The value is de-obfuscated. */
+    bool ReadRaw(Span<const unsigned char> key, std::vector<unsigned char>& value) const
+    {
+        return ReadRaw(key, value, readoptions);
+    }
+
+    bool ReadRaw(Span<const unsigned char> key, std::vector<unsigned char>& value, const leveldb::ReadOptions& otherOptions) const;
+
     template <typename K, typename V>
     bool Write(const K& key, const V& value, bool fSync = false)
     {
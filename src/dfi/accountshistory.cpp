@@ -4,6 +4,7 @@
 
 #include <dfi/accounts.h>
 #include <dfi/accountshistory.h>
+#include <dfi/customtx.h>
 #include <dfi/historywriter.h>
 #include <dfi/vaulthistory.h>
 #include <key_io.h>
@@ -96,6 +97,128 @@ CAccountHistoryStorage::CAccountHistoryStorage(std::shared_ptr<CDBWrapper> &db,
 CBurnHistoryStorage::CBurnHistoryStorage(const fs::path &dbName, std::size_t cacheSize, bool fMemory, bool fWipe)
     : CStorageView(new CStorageLevelDB(dbName, cacheSize, fMemory, fWipe)) {}
 
+void BurnHistoryTotals::Apply(const AccountHistoryValue &value, bool add) {
+    const auto sum = [&]() {
+        CAmount total{};
+        for (const auto &[id, amount] : value.diff) {
+            total += amount;
+        }
+        return add ? total : -total;
+    };
+    const auto apply = [&](CBalances &balances) {
+        for (const auto &[id, amount] : value.diff) {
+            // Negative diffs are never added, so they're not subtracted either
+            if (add) {
+                balances.Add({id, amount});
+            } else if (amount > 0) {
+                balances.Sub({id, amount});
+            }
+        }
+    };
+
+    switch (static_cast<CustomTxType>(value.category)) {
+        // UTXO burn
+        case CustomTxType::None:
+            burntDFI += sum();
+            break;
+        // Fee burn
+        case CustomTxType::CreateMasternode:
+        case CustomTxType::CreateToken:
+        case CustomTxType::Vault:
+        case CustomTxType::CreateCfp:
+        case CustomTxType::CreateVoc:
+            burntFee += sum();
+            break;
+        // withdraw burn
+        case CustomTxType::PaybackLoan:
+        case CustomTxType::PaybackLoanV2:
+        case CustomTxType::PaybackWithCollateral:
+            apply(paybackFee);
+            break;
+        // auction burn
+        case CustomTxType::AuctionBid:
+            auctionFee += sum();
+            break;
+        // dex fee burn
+        case CustomTxType::PoolSwap:
+        case CustomTxType::PoolSwapV2:
+            apply(dexfeeburn);
+            break;
+        // Token burn, with burnToken tx or any other
+        default:
+            apply(burntTokens);
+            break;
+    }
+}
+
+void CBurnHistoryStorage::CreateTotalsIfNeeded() {
+    if (Exists(ByBurnTotals::prefix())) {
+        return;
+    }
+
+    LogPrintf("Adding burn totals in progress...\n");
+
+    auto startTime = GetTimeMillis();
+
+    totals = BurnHistoryTotals{};
+    ForEach<ByAccountHistoryKey, AccountHistoryKey, AccountHistoryValue>(
+        [&](const AccountHistoryKey &, const AccountHistoryValue &value) {
+            totals->Add(value);
+            return true;
+        },
+        {{}, ~0u, ~0u});
+    WriteTotals();
+
+    Flush();
+
+    LogPrint(BCLog::BENCH, "    - Burn totals took: %dms\n", GetTimeMillis() - startTime);
+}
+
+const BurnHistoryTotals &CBurnHistoryStorage::GetBurnTotals() {
+    if (!totals) {
+        totals = BurnHistoryTotals{};
+        Read(ByBurnTotals::prefix(), *totals);
+    }
+    return *totals;
+}
+
+std::optional<AccountHistoryValue> CBurnHistoryStorage::ReadPendingAccountHistory(const AccountHistoryKey &key) const {
+    if (auto it = pending.find(DbTypeToBytes(key)); it != pending.end()) {
+        return it->second;
+    }
+    return ReadAccountHistory(key);
+}
+
+void CBurnHistoryStorage::WriteTotals() {
+    Write(ByBurnTotals::prefix(), *totals);
+}
+
+void CBurnHistoryStorage::WriteAccountHistory(const AccountHistoryKey &key, const AccountHistoryValue &value) {
+    GetBurnTotals();
+    if (auto prev = ReadPendingAccountHistory(key)) {
+        totals->Sub(*prev);
+    }
+    totals->Add(value);
+    WriteTotals();
+    pending[DbTypeToBytes(key)] = value;
+    CAccountsHistoryView::WriteAccountHistory(key, value);
+}
+
+Res CBurnHistoryStorage::EraseAccountHistory(const AccountHistoryKey &key) {
+    GetBurnTotals();
+    if (auto prev = ReadPendingAccountHistory(key)) {
+        totals->Sub(*prev);
+        WriteTotals();
+    }
+    pending[DbTypeToBytes(key)] = std::nullopt;
+    return CAccountsHistoryView::EraseAccountHistory(key);
+}
+
+bool CBurnHistoryStorage::Flush() {
+    pending.clear();
+    return CAccountsHistoryView::Flush();
+}
+
 CAccountsHistoryWriter::CAccountsHistoryWriter(CCustomCSView &storage,
                                                uint32_t height,
                                                uint32_t txn,
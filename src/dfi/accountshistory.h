@@ -23,8 +23,8 @@ public:
     void CreateMultiIndexIfNeeded();
     Res EraseAccountHistoryHeight(uint32_t height);
     [[nodiscard]] std::optional<AccountHistoryValue> ReadAccountHistory(const AccountHistoryKey &key) const;
-    void WriteAccountHistory(const AccountHistoryKey &key, const AccountHistoryValue &value);
-    Res EraseAccountHistory(const AccountHistoryKey &key);
+    virtual void WriteAccountHistory(const AccountHistoryKey &key, const AccountHistoryValue &value);
+    virtual Res EraseAccountHistory(const AccountHistoryKey &key);
     void ForEachAccountHistory(std::function<bool(const AccountHistoryKey &, AccountHistoryValue)> callback,
                                const CScript &owner = {},
                                uint32_t height = std::numeric_limits<uint32_t>::max(),
@@ -49,9 +49,59 @@ public:
     CStorageLevelDB &GetStorage() { return static_cast<CStorageLevelDB &>(DB()); }
 };
 
+// Burnt amounts of the burn history by category
+struct BurnHistoryTotals {
+    CAmount burntDFI{};
+    CAmount burntFee{};
+    CAmount auctionFee{};
+    CBalances burntTokens;
+    CBalances dexfeeburn;
+    CBalances paybackFee;
+
+    void Add(const AccountHistoryValue &value) { Apply(value, true); }
+    void Sub(const AccountHistoryValue &value) { Apply(value, false); }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action) {
+        READWRITE(burntDFI);
+        READWRITE(burntFee);
+        READWRITE(auctionFee);
+        READWRITE(burntTokens);
+        READWRITE(dexfeeburn);
+        READWRITE(paybackFee);
+    }
+
+private:
+    void Apply(const AccountHistoryValue &value, bool add);
+};
+
 class CBurnHistoryStorage : public CAccountsHistoryView {
 public:
     CBurnHistoryStorage(const fs::path &dbName, std::size_t cacheSize, bool fMemory = false, bool fWipe = false);
+
+    // Builds the totals from the whole history if the database predates them
+    void CreateTotalsIfNeeded();
+    // Totals are updated along with every history write and erase, including
+    // the ones not flushed yet
+    const BurnHistoryTotals &GetBurnTotals();
+
+    void WriteAccountHistory(const AccountHistoryKey &key, const AccountHistoryValue &value) override;
+    Res EraseAccountHistory(const AccountHistoryKey &key) override;
+    bool Flush() override;
+
+    struct ByBurnTotals {
+        static constexpr uint8_t prefix() { return 'b'; }
+    };
+
+private:
+    // Current value of a history entry, the leveldb batch can't be read back
+    std::optional<AccountHistoryValue> ReadPendingAccountHistory(const AccountHistoryKey &key) const;
+    void WriteTotals();
+
+    std::optional<BurnHistoryTotals> totals;
+    std::map<TBytes, std::optional<AccountHistoryValue>> pending;
 };
 
 class CAccountsHistoryWriter : public CCustomCSView {
@@ -190,7 +190,7 @@ Res CLoansConsensus::operator()(const CLoanSetCollateralTokenMessage &obj) const
     if (height >= static_cast<uint32_t>(consensus.DF16FortCanningCrunchHeight) && IsTokensMigratedToGovVar()) {
         const auto &tokenId = obj.idToken.v;
 
-        auto attributes = mnview.GetAttributes();
+        auto attributes = mnview.CopyAttributes();
         attributes->time = time;
 
         CDataStructureV0 collateralEnabled{AttributeTypes::Token, tokenId, TokenKeys::LoanCollateralEnabled};
@@ -311,7 +311,7 @@ Res CLoansConsensus::operator()(const CLoanSetLoanTokenMessage &obj) const {
     if (height >= static_cast<uint32_t>(consensus.DF16FortCanningCrunchHeight) && IsTokensMigratedToGovVar()) {
         const auto &id = tokenId.val->v;
 
-        auto attributes = mnview.GetAttributes();
+        auto attributes = mnview.CopyAttributes();
         attributes->time = time;
         attributes->evmTemplate = blockCtx.GetEVMTemplate();
 
@@ -440,7 +440,7 @@ Res CLoansConsensus::operator()(const CLoanUpdateLoanTokenMessage &obj) const {
     if (height >= static_cast<uint32_t>(consensus.DF16FortCanningCrunchHeight) && IsTokensMigratedToGovVar()) {
         const auto &id = pair->first.v;
 
-        auto attributes = mnview.GetAttributes();
+        auto attributes = mnview.CopyAttributes();
         attributes->time = time;
 
         CDataStructureV0 mintEnabled{AttributeTypes::Token, id, TokenKeys::LoanMintingEnabled};
@@ -903,7 +903,7 @@ Res CLoansConsensus::operator()(const CLoanPaybackLoanV2Message &obj) const {
     }
 
     auto shouldSetVariable = false;
-    auto attributes = mnview.GetAttributes();
+    auto attributes = mnview.CopyAttributes();
 
     for (const auto &[loanTokenId, paybackAmounts] : obj.loans) {
         const auto loanToken = mnview.GetLoanTokenByID(loanTokenId);
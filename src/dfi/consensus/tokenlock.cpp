@@ -21,7 +21,7 @@ Res CTokenLockConsensus::operator()(const CReleaseLockMessage &obj) const {
     auto &mnview = blockCtx.GetView();
 
     // get current ratio from attributes
-    auto attributes = mnview.GetAttributes();
+    auto attributes = mnview.CopyAttributes();
 
     CDataStructureV0 releaseKey{AttributeTypes::Live, ParamIDs::Economy, EconomyKeys::TokenLockRatio};
     auto currentRatio = attributes->GetValue(releaseKey, CAmount{});
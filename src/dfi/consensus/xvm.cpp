@@ -242,7 +242,7 @@ Res CXVMConsensus::operator()(const CTransferDomainMessage &obj) const {
         return res;
     }
 
-    auto attributes = mnview.GetAttributes();
+    auto attributes = mnview.CopyAttributes();
     auto stats = attributes->GetValue(CTransferDomainStatsLive::Key, CTransferDomainStatsLive{});
     std::string evmTxHash;
     CrossBoundaryResult result;
@@ -898,7 +898,7 @@ static void TrackLiveBalance(CCustomCSView &mnview,
                              const CTokenAmount &amount,
                              const EconomyKeys dataKey,
                              const bool add) {
-    auto attributes = mnview.GetAttributes();
+    auto attributes = mnview.CopyAttributes();
 
     CDataStructureV0 key{AttributeTypes::Live, ParamIDs::Economy, dataKey};
     auto balances = attributes->GetValue(key, CBalances{});
@@ -930,7 +930,7 @@ void TrackDUSDSub(CCustomCSView &mnview, const CTokenAmount &amount) {
 }
 
 void TrackLiveBalances(CCustomCSView &mnview, const CBalances &balances, const uint8_t key) {
-    auto attributes = mnview.GetAttributes();
+    auto attributes = mnview.CopyAttributes();
 
     const CDataStructureV0 liveKey{AttributeTypes::Live, ParamIDs::Auction, key};
     auto storedBalances = attributes->GetValue(liveKey, CBalances{});
@@ -941,7 +941,7 @@ void TrackLiveBalances(CCustomCSView &mnview, const CBalances &balances, const u
     mnview.SetVariable(*attributes);
 }
 
-bool IsEVMEnabled(const std::shared_ptr<ATTRIBUTES> attributes) {
+bool IsEVMEnabled(const std::shared_ptr<const ATTRIBUTES> &attributes) {
     if (!attributes) {
         return false;
     }
@@ -26,23 +26,29 @@ Res CGovView::SetVariable(const GovVariable &var) {
     if (var.GetName() != "ATTRIBUTES") {
         return WriteOrEraseVar(var);
     }
-    auto attributes = GetAttributes();
     auto &current = dynamic_cast<const ATTRIBUTES &>(var);
     if (current.changed.empty()) {
         return Res::Ok();
     }
-    for (auto &key : current.changed) {
-        auto it = current.attributes.find(key);
-        if (it == current.attributes.end()) {
-            attributes->attributes.erase(key);
-        } else {
-            attributes->attributes[key] = it->second;
+    // The undo of a tx, and with it the merkle root, needs an entry whenever
+    // the single blob would have been written, which is always unless there
+    // were no attributes before or after. Absent keys are erased regardless.
+    const auto recordErase = !current.attributes.empty() || !GetAttributes()->attributes.empty();
+    // Attributes are stored per key, only the changed ones are written
+    for (const auto &key : current.changed) {
+        if (auto it = current.attributes.find(key); it != current.attributes.end()) {
+            WriteBy<ByAttribute>(key, it->second);
+        } else if (recordErase) {
+            DB().Erase(DbTypeToBytes(std::make_pair(ByAttribute::prefix(), key)));
         }
     }
-    return WriteOrEraseVar(*attributes);
+    return Res::Ok();
 }
 
 std::shared_ptr<GovVariable> CGovView::GetVariable(const std::string &name) const {
+    if (name == ATTRIBUTES::TypeName()) {
+        return CopyAttributes();
+    }
     if (const auto var = GovVariable::Create(name)) {
         ReadBy<ByName>(var->GetName(), *var);
         return var;
@@ -158,10 +164,20 @@ void CGovView::EraseUnsetStoredVariables(const uint32_t height) {
     }
 }
 
-std::shared_ptr<ATTRIBUTES> CGovView::GetAttributes() const {
-    const auto var = GetVariable("ATTRIBUTES");
-    assert(var);
-    auto attributes = std::dynamic_pointer_cast<ATTRIBUTES>(var);
-    assert(attributes);
-    return attributes;
+std::shared_ptr<const ATTRIBUTES> CGovView::GetAttributes() const {
+    return ReadCachedPrefix<ByAttribute, ATTRIBUTES>([this] {
+        ATTRIBUTES attributes;
+        // it's safe needed by iterator creation
+        auto view = const_cast<CGovView *>(this);
+        view->ForEach<ByAttribute, CAttributeType, CAttributeValue>(
+            [&](const CAttributeType &key, const CAttributeValue &value) {
+                attributes.attributes.emplace(key, value);
+                return true;
+            });
+        return attributes;
+    });
+}
+
+std::shared_ptr<ATTRIBUTES> CGovView::CopyAttributes() const {
+    return std::make_shared<ATTRIBUTES>(*GetAttributes());
 }
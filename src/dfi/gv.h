@@ -52,6 +52,7 @@ public:
 
     virtual void Serialize(CVectorWriter &s) const = 0;
     virtual void Unserialize(VectorReader &s) = 0;
+    virtual void Unserialize(SpanReader &s) = 0;
 
     virtual void Serialize(CDataStream &s) const = 0;
     virtual void Unserialize(CDataStream &s) = 0;
@@ -114,7 +115,9 @@ public:
     std::multimap<std::string, std::map<uint64_t, std::vector<std::string>>> GetAllUnsetStoredVariables();
     void EraseUnsetStoredVariables(const uint32_t height);
 
-    std::shared_ptr<ATTRIBUTES> GetAttributes() const;
+    // Shared with the view cache, use CopyAttributes to modify
+    std::shared_ptr<const ATTRIBUTES> GetAttributes() const;
+    std::shared_ptr<ATTRIBUTES> CopyAttributes() const;
 
     [[nodiscard]] virtual bool AreTokensLocked(const std::set<uint32_t> &tokenIds) const = 0;
 
@@ -128,6 +131,10 @@ public:
     struct ByUnsetHeightVars {
         static constexpr uint8_t prefix() { return 0x7E; }
     };
+    // ATTRIBUTES entries, one per attribute key
+    struct ByAttribute {
+        static constexpr uint8_t prefix() { return 0x7F; }
+    };
 };
 
 struct CGovernanceUnsetMessage {
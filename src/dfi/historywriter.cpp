@@ -64,6 +64,20 @@ void CHistoryWriters::Flush(const uint32_t height,
                             const uint32_t txn,
                             const uint8_t type,
                             const uint256 &vaultID) {
+    if (deferred) {
+        deferredFlushes.push_back({std::move(diffs),
+                                   std::move(burnDiffs),
+                                   std::move(vaultDiffs),
+                                   std::move(globalLoanScheme),
+                                   std::move(schemeID),
+                                   height,
+                                   txid,
+                                   txn,
+                                   type,
+                                   vaultID});
+        ClearState();
+        return;
+    }
     if (historyView) {
         for (const auto &[owner, amounts] : diffs) {
             LogPrint(BCLog::ACCOUNTCHANGE,
@@ -99,6 +113,23 @@ void CHistoryWriters::Flush(const uint32_t height,
     ClearState();
 }
 
+void CHistoryWriters::SetDeferred(const bool defer) {
+    deferred = defer;
+}
+
+void CHistoryWriters::FlushDeferred() {
+    deferred = false;
+    for (auto &entry : deferredFlushes) {
+        diffs = std::move(entry.diffs);
+        burnDiffs = std::move(entry.burnDiffs);
+        vaultDiffs = std::move(entry.vaultDiffs);
+        globalLoanScheme = std::move(entry.globalLoanScheme);
+        schemeID = std::move(entry.schemeID);
+        Flush(entry.height, entry.txid, entry.txn, entry.type, entry.vaultID);
+    }
+    deferredFlushes.clear();
+}
+
 void CHistoryWriters::ClearState() {
     burnDiffs.clear();
     diffs.clear();
@@ -96,6 +96,22 @@ class CHistoryWriters {
     std::map<CScript, TAmounts> burnDiffs;
     std::map<uint256, std::map<CScript, TAmounts>> vaultDiffs;
 
+    struct DeferredFlush {
+        std::map<CScript, TAmounts> diffs;
+        std::map<CScript, TAmounts> burnDiffs;
+        std::map<uint256, std::map<CScript, TAmounts>> vaultDiffs;
+        CLoanSchemeCreation globalLoanScheme;
+        std::string schemeID;
+        uint32_t height;
+        uint256 txid;
+        uint32_t txn;
+        uint8_t type;
+        uint256 vaultID;
+    };
+
+    bool deferred{};
+    std::vector<DeferredFlush> deferredFlushes;
+
 public:
     CLoanSchemeCreation globalLoanScheme;
     std::string schemeID;
@@ -119,6 +135,10 @@ public:
                const uint32_t txn,
                const uint8_t type,
                const uint256 &vaultID);
+    // While deferred, Flush keeps the history in memory
+    // until FlushDeferred writes it to the storages
+    void SetDeferred(const bool defer);
+    void FlushDeferred();
 
     CBurnHistoryStorage *&GetBurnView();
     CVaultHistoryStorage *&GetVaultView();
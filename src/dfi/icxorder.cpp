@@ -470,6 +470,24 @@ Res CICXOrderView::ICXCloseOffer(const CICXCloseOfferImpl &closeoffer) {
     return Res::Ok();
 }
 
+template <typename By>
+void CICXOrderView::CollectExpiring(ExpiryType type, uint32_t height, std::vector<ExpiryEntry> &entries) {
+    for (auto it = LowerBound<By>(StatusKey{height, {}}); it.Valid() && it.Key().first == height; it.Next()) {
+        entries.push_back({type, it.Key().second, it.Value()});
+    }
+}
+
+std::vector<CICXOrderView::ExpiryEntry> CICXOrderView::GetICXExpiring(uint32_t height) {
+    // Closing an entry only erases its own status key, so the due set can be
+    // read ahead of processing
+    std::vector<ExpiryEntry> entries;
+    CollectExpiring<ICXOrderStatus>(ExpiryType::Order, height, entries);
+    CollectExpiring<ICXOfferStatus>(ExpiryType::MakeOffer, height, entries);
+    CollectExpiring<ICXSubmitDFCHTLCStatus>(ExpiryType::SubmitDFCHTLC, height, entries);
+    CollectExpiring<ICXSubmitEXTHTLCStatus>(ExpiryType::SubmitEXTHTLC, height, entries);
+    return entries;
+}
+
 Res CICXOrderView::ICXSetTakerFeePerBTC(CAmount amount) {
     WriteBy<ICXVariables>('A', amount);
 
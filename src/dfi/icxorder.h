@@ -445,6 +445,16 @@ public:
     std::unique_ptr<CICXCloseOfferImpl> GetICXCloseOfferByCreationTx(const uint256 &txid) const;
     Res ICXCloseOffer(const CICXCloseOfferImpl &closeoffer);
 
+    // Expiry scheduler
+    enum class ExpiryType : uint8_t { Order, MakeOffer, SubmitDFCHTLC, SubmitEXTHTLC };
+    struct ExpiryEntry {
+        ExpiryType type;
+        uint256 txid;
+        uint8_t status;
+    };
+    // Everything due at height in processing order: orders, offers, DFC and EXT HTLCs, each by txid
+    std::vector<ExpiryEntry> GetICXExpiring(uint32_t height);
+
     // ICX_TAKERFEE_PER_BTC
     Res ICXSetTakerFeePerBTC(CAmount amount);
     Res ICXEraseTakerFeePerBTC();
@@ -516,6 +526,10 @@ public:
     struct ICXVariables {
         static constexpr uint8_t prefix() { return 0x0F; }
     };
+
+private:
+    template <typename By>
+    void CollectExpiring(ExpiryType type, uint32_t height, std::vector<ExpiryEntry> &entries);
 };
 
 #endif  // DEFI_DFI_ICXORDER_H
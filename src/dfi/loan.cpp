@@ -137,7 +137,10 @@ std::optional<std::string> CLoanView::GetDefaultLoanScheme() {
 }
 
 std::optional<CLoanSchemeData> CLoanView::GetLoanScheme(const std::string &loanSchemeID) {
-    return ReadBy<LoanSchemeKey, CLoanSchemeData>(loanSchemeID);
+    if (const auto scheme = ReadCachedBy<LoanSchemeKey, CLoanSchemeData>(loanSchemeID)) {
+        return *scheme;
+    }
+    return {};
 }
 
 std::optional<uint64_t> CLoanView::GetDestroyLoanScheme(const std::string &loanSchemeID) {
@@ -8,6 +8,7 @@
 #include <dfi/anchors.h>
 #include <dfi/govvariables/attributes.h>
 #include <dfi/mn_checks.h>
+#include <dfi/threadpool.h>
 #include <dfi/vaulthistory.h>
 
 #include <chainparams.h>
@@ -29,6 +30,8 @@
 
 std::unique_ptr<CCustomCSView> pcustomcsview;
 std::unique_ptr<CStorageLevelDB> pcustomcsDB;
+CDecodedCacheStats decodedCacheStats;
+CStorageReadStats storageReadStats;
 
 int GetMnActivationDelay(int height) {
     // Restore previous activation delay on testnet after FC
@@ -243,6 +246,16 @@ void CMasternodesView::ForEachMasternode(std::function<bool(const uint256 &, CLa
     ForEach<ID, uint256, CMasternode>(callback, start);
 }
 
+void CMasternodesView::ForEachActiveCandidate(std::function<bool(const uint256 &, CMasternode)> callback, int height) {
+    ForEach<ByActiveUntil, MNActiveUntilKey, char>(
+        [&](const MNActiveUntilKey &key, char) {
+            const auto node = GetMasternode(key.masternodeID);
+            assert(node);
+            return callback(key.masternodeID, *node);
+        },
+        MNActiveUntilKey{static_cast<uint32_t>(std::max(height, 0)) + 1, uint256{}});
+}
+
 void CMasternodesView::IncrementMintedBy(const uint256 &nodeId) {
     auto node = GetMasternode(nodeId);
     assert(node);
@@ -312,6 +325,7 @@ Res CMasternodesView::CreateMasternode(const uint256 &nodeId, const CMasternode
     WriteBy<ID>(nodeId, node);
     WriteBy<Owner>(node.ownerAuthAddress, nodeId);
     WriteBy<Operator>(node.operatorAuthAddress, nodeId);
+    WriteBy<ByActiveUntil>(MNActiveUntilKey{std::numeric_limits<uint32_t>::max(), nodeId}, '\0');
 
     if (timelock > 0) {
         WriteBy<Timelock>(nodeId, timelock);
@@ -342,6 +356,12 @@ Res CMasternodesView::ResignMasternode(CMasternode &node, const uint256 &nodeId,
     node.resignHeight = height;
     WriteBy<ID>(nodeId, node);
 
+    // Both delays are used depending on height, past the longer one the node is resigned
+    const auto &consensus = Params().GetConsensus();
+    const auto inactiveHeight = height + std::max(consensus.mn.resignDelay, consensus.mn.newResignDelay);
+    EraseBy<ByActiveUntil>(MNActiveUntilKey{std::numeric_limits<uint32_t>::max(), nodeId});
+    WriteBy<ByActiveUntil>(MNActiveUntilKey{static_cast<uint32_t>(inactiveHeight), nodeId}, '\0');
+
     return Res::Ok();
 }
 
@@ -791,8 +811,8 @@ CCustomCSView::CCustomCSView(CStorageKV &st)
     CheckPrefixes();
 }
 
-CCustomCSView::CCustomCSView(std::unique_ptr<CStorageLevelDB> &st, MapKV &changed)
-    : CStorageView(new CFlushableStorageKV(st, changed)) {
+CCustomCSView::CCustomCSView(std::unique_ptr<CStorageLevelDB> &st, std::shared_ptr<const ArenaMapKV> changed)
+    : CStorageView(new CFlushableStorageKV(st, std::move(changed))) {
     CheckPrefixes();
 }
 
@@ -832,16 +852,18 @@ CTeamView::CTeam CCustomCSView::CalcNextTeam(int height, const uint256 &stakeMod
     int anchoringTeamSize = Params().GetConsensus().mn.anchoringTeamSize;
 
     std::map<arith_uint256, CKeyID, std::less<arith_uint256>> priorityMN;
-    ForEachMasternode([&](const uint256 &id, CMasternode node) {
-        if (!node.IsActive(height, *this)) {
-            return true;
-        }
+    ForEachActiveCandidate(
+        [&](const uint256 &id, CMasternode node) {
+            if (!node.IsActive(height, *this)) {
+                return true;
+            }
 
-        CDataStream ss{SER_GETHASH, PROTOCOL_VERSION};
-        ss << id << stakeModifier;
-        priorityMN.insert(std::make_pair(UintToArith256(Hash(ss.begin(), ss.end())), node.operatorAuthAddress));
-        return true;
-    });
+            CDataStream ss{SER_GETHASH, PROTOCOL_VERSION};
+            ss << id << stakeModifier;
+            priorityMN.insert(std::make_pair(UintToArith256(Hash(ss.begin(), ss.end())), node.operatorAuthAddress));
+            return true;
+        },
+        height);
 
     CTeam newTeam;
     auto &&it = priorityMN.begin();
@@ -869,28 +891,30 @@ void CCustomCSView::CalcAnchoringTeams(const uint256 &stakeModifier, const CBloc
 
     std::map<arith_uint256, CKeyID, std::less<arith_uint256>> authMN;
     std::map<arith_uint256, CKeyID, std::less<arith_uint256>> confirmMN;
-    ForEachMasternode([&](const uint256 &id, CMasternode node) {
-        if (!node.IsActive(pindexNew->nHeight, *this)) {
-            return true;
-        }
+    ForEachActiveCandidate(
+        [&](const uint256 &id, CMasternode node) {
+            if (!node.IsActive(pindexNew->nHeight, *this)) {
+                return true;
+            }
 
-        // Not in our list of MNs from last week, skip.
-        if (masternodeIDs.find(id) == masternodeIDs.end()) {
-            return true;
-        }
+            // Not in our list of MNs from last week, skip.
+            if (masternodeIDs.find(id) == masternodeIDs.end()) {
+                return true;
+            }
 
-        CDataStream authStream{SER_GETHASH, PROTOCOL_VERSION};
-        authStream << id << stakeModifier << static_cast<int>(AnchorTeams::AuthTeam);
-        authMN.insert(
-            std::make_pair(UintToArith256(Hash(authStream.begin(), authStream.end())), node.operatorAuthAddress));
+            CDataStream authStream{SER_GETHASH, PROTOCOL_VERSION};
+            authStream << id << stakeModifier << static_cast<int>(AnchorTeams::AuthTeam);
+            authMN.insert(
+                std::make_pair(UintToArith256(Hash(authStream.begin(), authStream.end())), node.operatorAuthAddress));
 
-        CDataStream confirmStream{SER_GETHASH, PROTOCOL_VERSION};
-        confirmStream << id << stakeModifier << static_cast<int>(AnchorTeams::ConfirmTeam);
-        confirmMN.insert(
-            std::make_pair(UintToArith256(Hash(confirmStream.begin(), confirmStream.end())), node.operatorAuthAddress));
+            CDataStream confirmStream{SER_GETHASH, PROTOCOL_VERSION};
+            confirmStream << id << stakeModifier << static_cast<int>(AnchorTeams::ConfirmTeam);
+            confirmMN.insert(std::make_pair(UintToArith256(Hash(confirmStream.begin(), confirmStream.end())),
+                                            node.operatorAuthAddress));
 
-        return true;
-    });
+            return true;
+        },
+        pindexNew->nHeight);
 
     int anchoringTeamSize = Params().GetConsensus().mn.anchoringTeamSize;
 
@@ -938,11 +962,11 @@ void CCustomCSView::CreateAndRelayConfirmMessageIfNeed(const CAnchorIndex::Ancho
 }
 
 void CCustomCSView::OnUndoTx(const uint256 &txid, uint32_t height) {
-    const auto undo = GetUndo(UndoKey{height, txid});
-    if (!undo) {
+    TBytes undo;
+    if (!GetUndoRaw(UndoKey{height, txid}, undo)) {
         return;  // not custom tx, or no changes done
     }
-    CUndo::Revert(GetStorage(), *undo);  // revert the changes of this tx
+    CUndo::Revert(GetStorage(), MakeSpan(undo));  // revert the changes of this tx
     DelUndo(UndoKey{height, txid});      // erase undo data, it served its purpose
 }
 
@@ -975,13 +999,12 @@ bool CCustomCSView::CalculateOwnerRewards(const CScript &owner, uint32_t targetH
     if (balanceHeight >= targetHeight) {
         return false;
     }
-    ForEachPoolId([&](DCT_ID const &poolId) {
-        auto height = GetShare(poolId, owner);
-        if (!height || *height >= targetHeight) {
-            return true;  // no share or target height is before a pool share' one
+    ForEachOwnerShare(owner, [&](DCT_ID const &poolId, const uint32_t shareHeight) {
+        if (shareHeight >= targetHeight) {
+            return true;  // target height is before a pool share' one
         }
         auto onLiquidity = [&]() -> CAmount { return GetBalance(owner, poolId).nValue; };
-        const auto beginHeight = std::max(*height, balanceHeight);
+        const auto beginHeight = std::max(shareHeight, balanceHeight);
         auto onReward = [&](RewardType, const CTokenAmount &amount, const uint32_t height) {
             if (auto res = AddBalance(owner, amount); !res) {
                 LogPrintf(
@@ -1191,37 +1214,249 @@ Res CCustomCSView::PopulateCollateralData(CVaultAssets &result,
     return Res::Ok();
 }
 
+// Vaults per collateralization scan task
+static constexpr size_t VAULT_SCAN_CHUNK_SIZE = 64;
+
+std::vector<std::optional<CVaultAssets>> CCustomCSView::GetVaultsBelowRatio(
+    const std::vector<std::pair<CVaultId, CBalances>> &vaultCollaterals,
+    uint32_t height,
+    int64_t blockTime,
+    bool useNextPrice,
+    bool requireLivePrice) {
+    struct VaultEntry {
+        bool valid{};
+        std::string schemeId;
+        size_t loansBegin{};
+        size_t loansEnd{};
+    };
+
+    // Loans of a chunk of vaults with interest added, stored column-wise
+    struct VaultChunk {
+        std::vector<VaultEntry> vaults;
+        std::vector<DCT_ID> loanTokens;
+        std::vector<CAmount> loanAmounts;
+    };
+
+    const auto count = vaultCollaterals.size();
+    std::vector<VaultChunk> chunks((count + VAULT_SCAN_CHUNK_SIZE - 1) / VAULT_SCAN_CHUNK_SIZE);
+
+    ParallelFor(count, VAULT_SCAN_CHUNK_SIZE, [&](const size_t begin, const size_t end) {
+        auto &chunk = chunks[begin / VAULT_SCAN_CHUNK_SIZE];
+        chunk.vaults.reserve(end - begin);
+        for (auto i = begin; i < end; ++i) {
+            const auto &vaultId = vaultCollaterals[i].first;
+            auto &entry = chunk.vaults.emplace_back();
+            entry.loansBegin = chunk.loanTokens.size();
+
+            const auto vault = GetVault(vaultId);
+            if (!vault || vault->isUnderLiquidation) {
+                continue;
+            }
+            entry.schemeId = vault->schemeId;
+            entry.valid = true;
+
+            const auto loanTokens = GetLoanTokens(vaultId);
+            if (!loanTokens) {
+                entry.loansEnd = entry.loansBegin;
+                continue;
+            }
+            for (const auto &[loanTokenId, loanTokenAmount] : loanTokens->balances) {
+                const auto rate = GetInterestRate(vaultId, loanTokenId, height);
+                if (!rate || height < rate->height) {
+                    entry.valid = false;
+                    break;
+                }
+                auto totalAmount = loanTokenAmount + TotalInterest(*rate, height);
+                if (totalAmount < 0) {
+                    totalAmount = 0;
+                }
+                chunk.loanTokens.push_back(loanTokenId);
+                chunk.loanAmounts.push_back(totalAmount);
+            }
+            if (!entry.valid) {
+                chunk.loanTokens.resize(entry.loansBegin);
+                chunk.loanAmounts.resize(entry.loansBegin);
+            }
+            entry.loansEnd = chunk.loanTokens.size();
+        }
+    });
+
+    // Price snapshot of every token and scheme referred by the batch
+    std::map<DCT_ID, std::optional<CAmount>> loanPrices;
+    std::map<DCT_ID, std::optional<std::pair<CAmount, CAmount>>> collateralPrices;
+    std::map<std::string, std::optional<uint32_t>> schemeRatios;
+
+    const auto validatedPrice = [&](const CTokenCurrencyPair &priceFeedId) -> std::optional<CAmount> {
+        if (auto price = GetValidatedIntervalPrice(priceFeedId, useNextPrice, requireLivePrice)) {
+            return *price.val;
+        }
+        return {};
+    };
+
+    for (const auto &chunk : chunks) {
+        for (const auto &tokenId : chunk.loanTokens) {
+            if (loanPrices.count(tokenId)) {
+                continue;
+            }
+            auto &price = loanPrices[tokenId];
+            if (const auto token = GetLoanTokenByID(tokenId)) {
+                price = validatedPrice(token->fixedIntervalPriceId);
+            }
+        }
+        for (const auto &entry : chunk.vaults) {
+            if (entry.valid && !schemeRatios.count(entry.schemeId)) {
+                auto &ratio = schemeRatios[entry.schemeId];
+                if (const auto scheme = GetLoanScheme(entry.schemeId)) {
+                    ratio = scheme->ratio;
+                }
+            }
+        }
+    }
+    for (const auto &[vaultId, collaterals] : vaultCollaterals) {
+        for (const auto &[tokenId, amount] : collaterals.balances) {
+            if (collateralPrices.count(tokenId)) {
+                continue;
+            }
+            auto &price = collateralPrices[tokenId];
+            if (const auto token = HasLoanCollateralToken({tokenId, height})) {
+                if (const auto value = validatedPrice(token->fixedIntervalPriceId)) {
+                    price = std::make_pair(token->factor, *value);
+                }
+            }
+        }
+    }
+
+    // Same overflow check as GetAmountInCurrency
+    const auto amountInCurrency = [](const CAmount amount, const CAmount price) -> std::optional<CAmount> {
+        const auto result = MultiplyAmounts(price, amount);
+        if (price > COIN && result < amount) {
+            return {};
+        }
+        return result;
+    };
+
+    std::vector<std::optional<CVaultAssets>> result(count);
+    ParallelFor(count, VAULT_SCAN_CHUNK_SIZE, [&](const size_t begin, const size_t end) {
+        const auto &chunk = chunks[begin / VAULT_SCAN_CHUNK_SIZE];
+        for (auto i = begin; i < end; ++i) {
+            const auto &entry = chunk.vaults[i - begin];
+            if (!entry.valid) {
+                continue;
+            }
+
+            CVaultAssets totals{};
+            auto valid = true;
+            for (auto j = entry.loansBegin; valid && j < entry.loansEnd; ++j) {
+                const auto price = loanPrices.find(chunk.loanTokens[j])->second;
+                const auto value = price ? amountInCurrency(chunk.loanAmounts[j], *price) : std::nullopt;
+                const auto prevLoans = totals.totalLoans;
+                valid = value && (totals.totalLoans += *value) >= prevLoans;
+            }
+            for (auto it = vaultCollaterals[i].second.balances.begin();
+                 valid && it != vaultCollaterals[i].second.balances.end();
+                 ++it) {
+                const auto &price = collateralPrices.find(it->first)->second;
+                const auto value = price ? amountInCurrency(it->second, price->second) : std::nullopt;
+                const auto prevCollaterals = totals.totalCollaterals;
+                valid = value && (totals.totalCollaterals += MultiplyAmounts(price->first, *value)) >= prevCollaterals;
+            }
+            if (!valid) {
+                continue;
+            }
+            const auto schemeRatio = schemeRatios.at(entry.schemeId);
+            assert(schemeRatio);
+            if (*schemeRatio <= totals.ratio()) {
+                // All good, within ratio, nothing more to do.
+                continue;
+            }
+
+            // Full valuation of the few vaults to liquidate
+            const auto &[vaultId, collaterals] = vaultCollaterals[i];
+            if (auto vaultAssets = GetVaultAssets(vaultId, collaterals, height, blockTime, useNextPrice, requireLivePrice)) {
+                result[i] = std::move(*vaultAssets.val);
+            }
+        }
+    });
+
+    return result;
+}
+
+// Leaves per merkle root task, the chunk is hashed and reduced to a node of the tree
+static constexpr unsigned int MERKLE_ROOT_CHUNK_LEVELS = 10;
+
 uint256 CCustomCSView::MerkleRoot() {
-    auto rawMap = GetStorage().GetRaw();
+    const auto &rawMap = GetStorage().GetRaw();
     if (rawMap.empty()) {
         return {};
     }
-    auto isAttributes = [](const TBytes &key) {
-        MapKV map = {std::make_pair(key, TBytes{})};
-        // Attributes should not be part of merkle root
-        static const std::string attributes("ATTRIBUTES");
-        auto it = NewKVIterator<CGovView::ByName>(attributes, map);
-        return it.Valid() && it.Key() == attributes;
+
+    // Attributes and indexes should not be part of merkle root
+    static const auto attributesKey =
+        DbTypeToBytes(std::make_pair(CGovView::ByName::prefix(), std::string{"ATTRIBUTES"}));
+    auto isAttributes = [](const auto &key) {
+        if (!key.empty() && (key[0] == CGovView::ByAttribute::prefix() ||
+                             key[0] == CPoolPairView::ByOwnerShare::prefix() ||
+                             key[0] == COracleView::ByPriceFeed::prefix() ||
+                             key[0] == CMasternodesView::ByActiveUntil::prefix())) {
+            return true;
+        }
+        return key.size() >= attributesKey.size() &&
+               std::equal(attributesKey.begin(), attributesKey.end(), key.begin());
+    };
+
+    static const TBytes empty;
+    auto leafHash = [&](const ArenaMapKVValue &entry) {
+        const auto &[key, value] = entry;
+        const auto &bytes = value ? *value : empty;
+        std::pair<uint8_t, UndoKey> undoKey;
+        CUndo undo;
+        if (value && !key.empty() && key[0] == CUndosView::ByUndoKey::prefix() &&
+            BytesToDbType(TBytesView{key.data(), key.size()}, undoKey) && BytesToDbType(bytes, undo)) {
+            auto &map = undo.before;
+            const auto size = map.size();
+            for (auto it = map.begin(); it != map.end();) {
+                isAttributes(it->first) ? map.erase(it++) : ++it;
+            }
+            // Undo entries are hashed without attributes
+            if (map.size() != size) {
+                const auto stripped = DbTypeToBytes(undo);
+                return Hash(key.begin(), key.end(), stripped.begin(), stripped.end());
+            }
+        }
+        return Hash(key.begin(), key.end(), bytes.begin(), bytes.end());
     };
 
-    auto it = NewKVIterator<CUndosView::ByUndoKey>(UndoKey{}, rawMap);
-    for (; it.Valid(); it.Next()) {
-        CUndo value = it.Value();
-        auto &map = value.before;
-        for (auto it = map.begin(); it != map.end();) {
-            isAttributes(it->first) ? map.erase(it++) : ++it;
+    std::vector<const ArenaMapKVValue *> leaves;
+    leaves.reserve(rawMap.size());
+    for (const auto &entry : rawMap) {
+        if (!isAttributes(entry.first)) {
+            leaves.push_back(&entry);
         }
-        auto key = std::make_pair(CUndosView::ByUndoKey::prefix(), static_cast<const UndoKey &>(it.Key()));
-        rawMap[DbTypeToBytes(key)] = DbTypeToBytes(value);
     }
 
-    std::vector<uint256> hashes;
-    for (const auto &[key, value] : rawMap) {
-        if (!isAttributes(key)) {
-            hashes.push_back(Hash2(key, value ? *value : TBytes{}));
+    const auto chunkSize = size_t{1} << MERKLE_ROOT_CHUNK_LEVELS;
+    const auto chunks = (leaves.size() + chunkSize - 1) / chunkSize;
+    if (chunks < 2) {
+        std::vector<uint256> hashes;
+        hashes.reserve(leaves.size());
+        for (const auto entry : leaves) {
+            hashes.push_back(leafHash(*entry));
         }
+        return ComputeMerkleRoot(std::move(hashes));
     }
-    return ComputeMerkleRoot(std::move(hashes));
+
+    std::vector<uint256> roots(chunks);
+    ParallelFor(leaves.size(), chunkSize, [&](const size_t begin, const size_t end) {
+        std::vector<uint256> hashes;
+        hashes.reserve(chunkSize);
+        for (auto pos = begin; pos < end; ++pos) {
+            hashes.push_back(leafHash(*leaves[pos]));
+        }
+        ReduceMerkleLevels(hashes, MERKLE_ROOT_CHUNK_LEVELS);
+        roots[begin / chunkSize] = hashes[0];
+    });
+
+    return ComputeMerkleRoot(std::move(roots));
 }
 
 // FIXME: this returns true if *any* of the tokenIds is locked. feels wrong.
@@ -240,6 +240,22 @@ struct MNNewOwnerHeightValue {
     }
 };
 
+// Upper bound of the heights a masternode can be active at. Resigned nodes are
+// keyed by the first height at which they are certainly inactive, the others
+// by max uint32_t.
+struct MNActiveUntilKey {
+    uint32_t height;
+    uint256 masternodeID;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action) {
+        READWRITE(WrapBigEndian(height));
+        READWRITE(masternodeID);
+    }
+};
+
 class CMasternodesView : public virtual CStorageView {
     std::map<CKeyID, std::pair<uint32_t, int64_t>> minterTimeCache;
 
@@ -249,6 +265,9 @@ public:
     std::optional<uint256> GetMasternodeIdByOwner(const CKeyID &id) const;
     void ForEachMasternode(std::function<bool(const uint256 &, CLazySerialize<CMasternode>)> callback,
                            const uint256 &start = uint256());
+    // Visits the masternodes that can still be active at height, i.e. skips the
+    // ones resigned long enough ago. Callers check IsActive on each node.
+    void ForEachActiveCandidate(std::function<bool(const uint256 &, CMasternode)> callback, int height);
 
     void IncrementMintedBy(const uint256 &nodeId);
     void DecrementMintedBy(const uint256 &nodeId);
@@ -341,6 +360,11 @@ public:
     struct Timelock {
         static constexpr uint8_t prefix() { return 'K'; }
     };
+
+    // Derived index of masternodes by MNActiveUntilKey
+    struct ByActiveUntil {
+        static constexpr uint8_t prefix() { return 0x1F; }
+    };
 };
 
 class CLastHeightView : public virtual CStorageView {
@@ -493,7 +517,7 @@ class CCustomCSView : public CMasternodesView,
     void CheckPrefixes()
     {
         CheckPrefix<
-            CMasternodesView        ::  ID, NewCollateral, PendingHeight, Operator, Owner, Staker, SubNode, Timelock,
+            CMasternodesView        ::  ID, NewCollateral, PendingHeight, Operator, Owner, Staker, SubNode, Timelock, ByActiveUntil,
             CLastHeightView         ::  Height,
             CTeamView               ::  AuthTeam, ConfirmTeam, CurrentTeam,
             CFoundationsDebtView    ::  Debt,
@@ -506,9 +530,10 @@ class CCustomCSView : public CMasternodesView,
                                         ByPoolReward, ByDailyReward, ByCustomReward, ByTotalLiquidity, ByDailyLoanReward,
                                         ByPoolLoanReward, ByTokenDexFeePct, ByLoanTokenLiquidityPerBlock, ByLoanTokenLiquidityAverage,
                                         ByTotalRewardPerShare, ByTotalLoanRewardPerShare, ByTotalCustomRewardPerShare, ByTotalCommissionPerShare,
-            CGovView                ::  ByName, ByHeightVars, ByUnsetHeightVars,
+                                        ByOwnerShare,
+            CGovView                ::  ByName, ByHeightVars, ByUnsetHeightVars, ByAttribute,
             CAnchorConfirmsView     ::  BtcTx,
-            COracleView             ::  ByName, FixedIntervalBlockKey, FixedIntervalPriceKey, PriceDeviation,
+            COracleView             ::  ByName, FixedIntervalBlockKey, FixedIntervalPriceKey, PriceDeviation, ByPriceFeed,
             CICXOrderView           ::  ICXOrderCreationTx, ICXMakeOfferCreationTx, ICXSubmitDFCHTLCCreationTx,
                                         ICXSubmitEXTHTLCCreationTx, ICXClaimDFCHTLCCreationTx, ICXCloseOrderCreationTx,
                                         ICXCloseOfferCreationTx, ICXOrderOpenKey, ICXOrderCloseKey, ICXMakeOfferOpenKey,
@@ -547,14 +572,14 @@ protected:
 
 public:
     // Increase version when underlaying tables are changed
-    static constexpr const int DbVersion = 1;
+    static constexpr const int DbVersion = 5;
 
     // Normal constructors
     CCustomCSView();
     explicit CCustomCSView(CStorageKV &st);
 
     // Snapshot constructor
-    explicit CCustomCSView(std::unique_ptr<CStorageLevelDB> &st, MapKV &changed);
+    explicit CCustomCSView(std::unique_ptr<CStorageLevelDB> &st, std::shared_ptr<const ArenaMapKV> changed);
 
     // Cache-upon-a-cache constructors
     CCustomCSView(CCustomCSView &other);
@@ -595,6 +620,17 @@ public:
                                         bool useNextPrice = false,
                                         bool requireLivePrice = true);
 
+    // Collateralization check of many vaults at the same height. Token prices, factors
+    // and scheme ratios are read once for the batch and the vaults are valued in parallel
+    // chunks. Returns the assets of the vaults below their scheme ratio in input order,
+    // the entries of healthy vaults and of vaults that can't be valued are left empty.
+    std::vector<std::optional<CVaultAssets>> GetVaultsBelowRatio(
+        const std::vector<std::pair<CVaultId, CBalances>> &vaultCollaterals,
+        uint32_t height,
+        int64_t blockTime,
+        bool useNextPrice = false,
+        bool requireLivePrice = true);
+
     ResVal<CAmount> GetValidatedIntervalPrice(const CTokenCurrencyPair &priceFeedId,
                                               bool useNextPrice,
                                               bool requireLivePrice);
@@ -426,6 +426,130 @@ bool IsDisabledTx(uint32_t height, const CTransaction &tx, const Consensus::Para
     return IsDisabledTx(height, txType, consensus);
 }
 
+void CCustomTxReadHints::Merge(CCustomTxReadHints &other) {
+    balances.merge(other.balances);
+    tokenPairs.merge(other.tokenPairs);
+    pools.merge(other.pools);
+    vaults.merge(other.vaults);
+}
+
+bool CCustomTxReadHints::Empty() const {
+    return balances.empty() && tokenPairs.empty() && pools.empty() && vaults.empty();
+}
+
+class CCustomTxReadHintsVisitor {
+    CCustomTxReadHints &hints;
+
+    void AddBalances(const CScript &owner, const CBalances &balances) {
+        for (const auto &[tokenId, amount] : balances.balances) {
+            hints.balances.emplace(owner, tokenId);
+        }
+    }
+
+    void AddBalances(const CAccounts &accounts) {
+        for (const auto &[owner, balances] : accounts) {
+            AddBalances(owner, balances);
+        }
+    }
+
+public:
+    explicit CCustomTxReadHintsVisitor(CCustomTxReadHints &hints)
+        : hints(hints) {}
+
+    void operator()(const CUtxosToAccountMessage &obj) { AddBalances(obj.to); }
+
+    void operator()(const CAccountToUtxosMessage &obj) { AddBalances(obj.from, obj.balances); }
+
+    void operator()(const CAccountToAccountMessage &obj) {
+        AddBalances(obj.from, SumAllTransfers(obj.to));
+        AddBalances(obj.to);
+    }
+
+    void operator()(const CAnyAccountsToAccountsMessage &obj) {
+        AddBalances(obj.from);
+        AddBalances(obj.to);
+    }
+
+    void operator()(const CPoolSwapMessage &obj) {
+        hints.balances.emplace(obj.from, obj.idTokenFrom);
+        hints.balances.emplace(obj.to, obj.idTokenTo);
+        // The direct pool is looked up in both orders
+        hints.tokenPairs.emplace(obj.idTokenFrom, obj.idTokenTo);
+        hints.tokenPairs.emplace(obj.idTokenTo, obj.idTokenFrom);
+    }
+
+    void operator()(const CPoolSwapMessageV2 &obj) {
+        (*this)(obj.swapInfo);
+        hints.pools.insert(obj.poolIDs.begin(), obj.poolIDs.end());
+    }
+
+    void operator()(const CLiquidityMessage &obj) { AddBalances(obj.from); }
+
+    void operator()(const CRemoveLiquidityMessage &obj) {
+        hints.balances.emplace(obj.from, obj.amount.nTokenId);
+        hints.pools.insert(obj.amount.nTokenId);
+    }
+
+    void operator()(const CDepositToVaultMessage &obj) {
+        hints.balances.emplace(obj.from, obj.amount.nTokenId);
+        hints.vaults.insert(obj.vaultId);
+    }
+
+    void operator()(const CWithdrawFromVaultMessage &obj) {
+        hints.balances.emplace(obj.to, obj.amount.nTokenId);
+        hints.vaults.insert(obj.vaultId);
+    }
+
+    void operator()(const CLoanTakeLoanMessage &obj) {
+        AddBalances(obj.to, obj.amounts);
+        hints.vaults.insert(obj.vaultId);
+    }
+
+    void operator()(const CLoanPaybackLoanMessage &obj) {
+        AddBalances(obj.from, obj.amounts);
+        hints.vaults.insert(obj.vaultId);
+    }
+
+    void operator()(const CLoanPaybackLoanV2Message &obj) {
+        for (const auto &[collateralId, amounts] : obj.loans) {
+            AddBalances(obj.from, amounts);
+        }
+        hints.vaults.insert(obj.vaultId);
+    }
+
+    void operator()(const CFutureSwapMessage &obj) { hints.balances.emplace(obj.owner, obj.source.nTokenId); }
+
+    template <typename T>
+    void operator()(const T &) {}
+};
+
+CCustomTxReadHints GetCustomTxReadHints(const CCustomTxMessage &txMessage) {
+    CCustomTxReadHints hints;
+    std::visit(CCustomTxReadHintsVisitor(hints), txMessage);
+    return hints;
+}
+
+void PrefetchCustomTxReads(CStorageKV &db, const CCustomTxReadHints &hints) {
+    std::vector<TBytes> keys;
+    keys.reserve(hints.balances.size() + hints.tokenPairs.size() + 2 * hints.pools.size() + 3 * hints.vaults.size());
+    for (const auto &[owner, tokenId] : hints.balances) {
+        keys.push_back(DbTypeToBytes(std::make_pair(CAccountsView::ByBalanceKey::prefix(), BalanceKey{owner, tokenId})));
+    }
+    for (const auto &[tokenA, tokenB] : hints.tokenPairs) {
+        keys.push_back(DbTypeToBytes(std::make_pair(CPoolPairView::ByPair::prefix(), ByPairKey{tokenA, tokenB})));
+    }
+    for (const auto &poolId : hints.pools) {
+        keys.push_back(DbTypeToBytes(std::make_pair(CPoolPairView::ByID::prefix(), poolId)));
+        keys.push_back(DbTypeToBytes(std::make_pair(CPoolPairView::ByReserves::prefix(), poolId)));
+    }
+    for (const auto &vaultId : hints.vaults) {
+        keys.push_back(DbTypeToBytes(std::make_pair(CVaultView::VaultKey::prefix(), vaultId)));
+        keys.push_back(DbTypeToBytes(std::make_pair(CVaultView::CollateralKey::prefix(), vaultId)));
+        keys.push_back(DbTypeToBytes(std::make_pair(CLoanView::LoanTokenAmount::prefix(), vaultId)));
+    }
+    db.Prefetch(keys);
+}
+
 Res CustomTxVisit(const CCustomTxMessage &txMessage, BlockContext &blockCtx, const TransactionContext &txCtx) {
     const auto &consensus = txCtx.GetConsensus();
     const auto height = txCtx.GetHeight();
@@ -629,12 +753,13 @@ Res ApplyCustomTx(BlockContext &blockCtx, TransactionContext &txCtx) {
 
     // construct undo
     auto &flushable = view.GetStorage();
-    auto undo = CUndo::Construct(mnview.GetStorage(), flushable.GetRaw());
+    const auto hasChanges = !flushable.GetRaw().empty();
+    const auto undo = hasChanges ? CUndo::ConstructRaw(mnview.GetStorage(), flushable.GetRaw()) : TBytes{};
     // flush changes
     view.Flush();
     // write undo
-    if (!undo.before.empty()) {
-        mnview.SetUndo(UndoKey{height, tx.GetHash()}, undo);
+    if (hasChanges) {
+        mnview.SetUndoRaw(UndoKey{height, tx.GetHash()}, undo);
     }
     return res;
 }
@@ -989,7 +1114,7 @@ Res CPoolSwap::ExecuteSwap(CCustomCSView &view,
         mnview.Flush();
     }
 
-    auto attributes = view.GetAttributes();
+    auto attributes = view.CopyAttributes();
 
     CDataStructureV0 dexKey{AttributeTypes::Live, ParamIDs::Economy, EconomyKeys::DexTokens};
     auto dexBalances = attributes->GetValue(dexKey, CDexBalances{});
@@ -1298,9 +1423,12 @@ bool OraclePriceFeed(CCustomCSView &view, const CTokenCurrencyPair &priceFeed) {
         return true;
     }
     bool found = false;
-    view.ForEachOracle([&](const COracleId &, COracle oracle) {
-        return !(found = oracle.SupportsPair(priceFeed.first, priceFeed.second));
-    });
+    view.ForEachOraclePriceFeed(
+        [&](const COraclePriceFeedKey &key, CLazySerialize<COraclePriceFeedValue>) {
+            found = key.priceFeedId == priceFeed;
+            return false;
+        },
+        {priceFeed, {}});
     return found;
 }
 
@@ -233,6 +233,22 @@ Res ApplyCustomTx(BlockContext &blockCtx, TransactionContext &txCtx);
 
 Res CustomTxVisit(const CCustomTxMessage &txMessage, BlockContext &blockCtx, const TransactionContext &txCtx);
 
+// Balances, pools and vaults a custom tx is expected to read
+struct CCustomTxReadHints {
+    std::set<std::pair<CScript, DCT_ID>> balances;
+    std::set<std::pair<DCT_ID, DCT_ID>> tokenPairs;
+    std::set<DCT_ID> pools;
+    std::set<CVaultId> vaults;
+
+    void Merge(CCustomTxReadHints &other);
+    [[nodiscard]] bool Empty() const;
+};
+
+CCustomTxReadHints GetCustomTxReadHints(const CCustomTxMessage &txMessage);
+// Passes the database keys of the hints to CStorageKV::Prefetch. Safe to call
+// from any thread on a database storage.
+void PrefetchCustomTxReads(CStorageKV &db, const CCustomTxReadHints &hints);
+
 ResVal<uint256> ApplyAnchorRewardTx(CCustomCSView &mnview,
                                     const CTransaction &tx,
                                     int height,
@@ -248,6 +264,8 @@ ResVal<CAmount> GetAggregatePrice(CCustomCSView &view,
                                   const std::string &token,
                                   const std::string &currency,
                                   uint64_t lastBlockTime);
+// Aggregated prices of all the price feeds supported by an oracle, in a single pass
+std::map<CTokenCurrencyPair, ResVal<CAmount>> GetAggregatePrices(CCustomCSView &view, uint64_t lastBlockTime);
 bool IsVaultPriceValid(CCustomCSView &mnview, const CVaultId &vaultId, uint32_t height);
 Res SwapToDFIorDUSD(CCustomCSView &mnview,
                     DCT_ID tokenId,
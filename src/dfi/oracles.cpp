@@ -30,10 +30,29 @@ ResVal<CAmount> COracle::GetTokenPrice(const std::string &token, const std::stri
     return ResVal<CAmount>(tokenPrices[token][currency].first, Res::Ok());
 }
 
+void COracleView::WritePriceFeeds(const COracleId &oracleId, const COracle &oracle) {
+    for (const auto &priceFeedId : oracle.availablePairs) {
+        COraclePriceFeedValue value{oracle.weightage, {}};
+        if (const auto token = oracle.tokenPrices.find(priceFeedId.first); token != oracle.tokenPrices.end()) {
+            if (const auto price = token->second.find(priceFeedId.second); price != token->second.end()) {
+                value.price = price->second;
+            }
+        }
+        WriteBy<ByPriceFeed>(COraclePriceFeedKey{priceFeedId, oracleId}, value);
+    }
+}
+
+void COracleView::ErasePriceFeeds(const COracleId &oracleId, const COracle &oracle) {
+    for (const auto &priceFeedId : oracle.availablePairs) {
+        EraseBy<ByPriceFeed>(COraclePriceFeedKey{priceFeedId, oracleId});
+    }
+}
+
 Res COracleView::AppointOracle(const COracleId &oracleId, const COracle &oracle) {
     if (!WriteBy<ByName>(oracleId, oracle)) {
         return Res::Err("failed to appoint the new oracle <%s>", oracleId.GetHex());
     }
+    WritePriceFeeds(oracleId, oracle);
 
     return Res::Ok();
 }
@@ -63,6 +82,7 @@ Res COracleView::UpdateOracle(const COracleId &oracleId, COracle &&newOracle) {
         }
     }
 
+    ErasePriceFeeds(oracleId, oracle);
     oracle.tokenPrices = std::move(allowedPrices);
     oracle.availablePairs = std::move(newOracle.availablePairs);
 
@@ -70,12 +90,14 @@ Res COracleView::UpdateOracle(const COracleId &oracleId, COracle &&newOracle) {
     if (!WriteBy<ByName>(oracleId, oracle)) {
         return Res::Err("failed to save oracle <%s>", oracleId.GetHex());
     }
+    WritePriceFeeds(oracleId, oracle);
 
     return Res::Ok();
 }
 
 Res COracleView::RemoveOracle(const COracleId &oracleId) {
-    if (!ExistsBy<ByName>(oracleId)) {
+    COracle oracle;
+    if (!ReadBy<ByName>(oracleId, oracle)) {
         return Res::Err("oracle <%s> not found", oracleId.GetHex());
     }
 
@@ -83,6 +105,7 @@ Res COracleView::RemoveOracle(const COracleId &oracleId) {
     if (!EraseBy<ByName>(oracleId)) {
         return Res::Err("failed to remove oracle <%s>", oracleId.GetHex());
     }
+    ErasePriceFeeds(oracleId, oracle);
 
     return Res::Ok();
 }
@@ -106,6 +129,7 @@ Res COracleView::SetOracleData(const COracleId &oracleId, int64_t timestamp, con
     if (!WriteBy<ByName>(oracleId, oracle)) {
         return Res::Err("failed to store oracle %s to database", oracleId.GetHex());
     }
+    WritePriceFeeds(oracleId, oracle);
     return Res::Ok();
 }
 
@@ -123,6 +147,12 @@ void COracleView::ForEachOracle(std::function<bool(const COracleId &, CLazySeria
     ForEach<ByName, COracleId, COracle>(callback, start);
 }
 
+void COracleView::ForEachOraclePriceFeed(
+    std::function<bool(const COraclePriceFeedKey &, CLazySerialize<COraclePriceFeedValue>)> callback,
+    const COraclePriceFeedKey &start) {
+    ForEach<ByPriceFeed, COraclePriceFeedKey, COraclePriceFeedValue>(callback, start);
+}
+
 bool CFixedIntervalPrice::isLive(const CAmount deviationThreshold) const {
     return (priceRecord[0] > 0 && priceRecord[1] > 0 &&
             (std::abs(priceRecord[1] - priceRecord[0]) < MultiplyAmounts(priceRecord[0], deviationThreshold)));
@@ -147,11 +177,12 @@ Res COracleView::SetFixedIntervalPrice(const CFixedIntervalPrice &fixedIntervalP
 }
 
 ResVal<CFixedIntervalPrice> COracleView::GetFixedIntervalPrice(const CTokenCurrencyPair &fixedIntervalPriceId) {
-    CFixedIntervalPrice fixedIntervalPrice;
-    if (!ReadBy<FixedIntervalPriceKey>(fixedIntervalPriceId, fixedIntervalPrice)) {
+    const auto cached = ReadCachedBy<FixedIntervalPriceKey, CFixedIntervalPrice>(fixedIntervalPriceId);
+    if (!cached) {
         return Res::Err(
             "fixedIntervalPrice with id <%s/%s> not found", fixedIntervalPriceId.first, fixedIntervalPriceId.second);
     }
+    auto fixedIntervalPrice = *cached;
 
     DCT_ID firstID{}, secondID{};
     const auto firstToken = GetTokenGuessId(fixedIntervalPriceId.first, firstID);
@@ -11,6 +11,7 @@
 #include <flushablestorage.h>
 #include <script/script.h>
 #include <serialize.h>
+#include <serialize_optional.h>
 #include <uint256.h>
 
 #include <string>
@@ -112,6 +113,37 @@ struct CFixedIntervalPrice {
     }
 };
 
+struct COraclePriceFeedKey {
+    CTokenCurrencyPair priceFeedId;
+    COracleId oracleId;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action) {
+        READWRITE(priceFeedId);
+        READWRITE(oracleId);
+    }
+};
+
+/// Latest price of an oracle for one of its price feeds
+struct COraclePriceFeedValue {
+    uint8_t weightage;
+    std::optional<CPriceTimePair> price;
+
+    template <typename Stream>
+    void Serialize(Stream &s) const {
+        s << weightage;
+        ::Serialize(s, price);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream &s) {
+        s >> weightage;
+        ::Unserialize(s, price);
+    }
+};
+
 struct CFuturesPrice {
     CAmount discount;
     CAmount premium;
@@ -140,6 +172,11 @@ public:
     void ForEachOracle(std::function<bool(const COracleId &, CLazySerialize<COracle>)> callback,
                        const COracleId &start = {});
 
+    /// oracles of the price feeds with their latest prices, ordered by price feed
+    void ForEachOraclePriceFeed(
+        std::function<bool(const COraclePriceFeedKey &, CLazySerialize<COraclePriceFeedValue>)> callback,
+        const COraclePriceFeedKey &start = {});
+
     Res SetFixedIntervalPrice(const CFixedIntervalPrice &PriceFeed);
 
     ResVal<CFixedIntervalPrice> GetFixedIntervalPrice(const CTokenCurrencyPair &priceFeedId);
@@ -173,6 +210,13 @@ public:
     struct FixedIntervalPriceKey {
         static constexpr uint8_t prefix() { return 'y'; }
     };
+    struct ByPriceFeed {
+        static constexpr uint8_t prefix() { return 0x1E; }
+    };
+
+private:
+    void WritePriceFeeds(const COracleId &oracleId, const COracle &oracle);
+    void ErasePriceFeeds(const COracleId &oracleId, const COracle &oracle);
 };
 
 #endif  // DEFI_DFI_ORACLES_H
@@ -138,10 +138,11 @@ Res CPoolPairView::UpdatePoolPair(DCT_ID const &poolId,
 }
 
 std::optional<CPoolPair> CPoolPairView::GetPoolPair(const DCT_ID &poolId) const {
-    auto pool = ReadBy<ByID, CPoolPair>(poolId);
-    if (!pool) {
+    const auto cached = ReadCachedBy<ByID, CPoolPair>(poolId);
+    if (!cached) {
         return {};
     }
+    std::optional<CPoolPair> pool{*cached};
     if (auto reserves = ReadBy<ByReserves, PoolReservesValue>(poolId)) {
         pool->reserveA = reserves->reserveA;
         pool->reserveB = reserves->reserveB;
@@ -761,6 +762,7 @@ std::pair<CAmount, CAmount> CPoolPairView::UpdatePoolRewards(
 
 Res CPoolPairView::SetShare(DCT_ID const &poolId, const CScript &provider, uint32_t height) {
     WriteBy<ByShare>(PoolShareKey{poolId, provider}, height);
+    WriteBy<ByOwnerShare>(OwnerShareKey{provider, poolId}, height);
     return Res::Ok();
 }
 
@@ -853,6 +855,7 @@ TotalCommissionPerShareValue CPoolPairView::GetTotalCommissionPerShare(const Tot
 
 Res CPoolPairView::DelShare(DCT_ID const &poolId, const CScript &provider) {
     EraseBy<ByShare>(PoolShareKey{poolId, provider});
+    EraseBy<ByOwnerShare>(OwnerShareKey{provider, poolId});
     return Res::Ok();
 }
 
@@ -934,6 +937,18 @@ void CPoolPairView::ForEachPoolShare(std::function<bool(DCT_ID const &, const CS
         startKey);
 }
 
+void CPoolPairView::ForEachOwnerShare(const CScript &owner,
+                                      std::function<bool(DCT_ID const &, uint32_t)> callback) {
+    ForEach<ByOwnerShare, OwnerShareKey, uint32_t>(
+        [&](const OwnerShareKey &key, uint32_t height) {
+            if (key.owner != owner) {
+                return false;
+            }
+            return callback(key.poolID, height);
+        },
+        OwnerShareKey{owner, DCT_ID{0}});
+}
+
 Res CPoolPairView::SetDexFeePct(DCT_ID poolId, DCT_ID tokenId, CAmount feePct) {
     if (feePct < 0 || feePct > COIN) {
         return Res::Err("Token dex fee should be in percentage");
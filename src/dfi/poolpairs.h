@@ -225,6 +225,19 @@ struct PoolShareKey {
     }
 };
 
+struct OwnerShareKey {
+    CScript owner;
+    DCT_ID poolID;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action) {
+        READWRITE(owner);
+        READWRITE(WrapBigEndian(poolID.v));
+    }
+};
+
 struct TotalRewardPerShareKey {
     uint32_t height;
     uint32_t poolID;
@@ -358,6 +371,8 @@ public:
     Res DelShare(DCT_ID const &poolId, const CScript &provider);
 
     std::optional<uint32_t> GetShare(DCT_ID const &poolId, const CScript &provider);
+    // Shares of the owner in ascending pool id order
+    void ForEachOwnerShare(const CScript &owner, std::function<bool(DCT_ID const &, uint32_t)> callback);
 
     void CalculatePoolRewards(DCT_ID const &poolId,
                               std::function<CAmount()> onLiquidity,
@@ -478,6 +493,10 @@ public:
     struct ByTotalCommissionPerShare {
         static constexpr uint8_t prefix() { return 0x7B; }
     };
+    // Index of ByShare by owner, not part of merkle root
+    struct ByOwnerShare {
+        static constexpr uint8_t prefix() { return 0x1D; }
+    };
 };
 
 template <typename By, typename ReturnType>
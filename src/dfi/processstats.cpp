@@ -0,0 +1,188 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <dfi/processstats.h>
+
+#include <dfi/customtx.h>
+#include <flushablestorage.h>
+#include <util/time.h>
+
+CDeFiProcessStats deFiProcessStats;
+
+void ProcessTimeHistogram::Add(const int64_t time) {
+    size_t bucket{};
+    for (auto value = std::max<int64_t>(time, 0); value && bucket < BUCKETS - 1; value >>= 1) {
+        ++bucket;
+    }
+    ++buckets[bucket];
+    ++count;
+    total += time;
+    max = std::max(max, time);
+}
+
+UniValue ProcessTimeHistogram::ToJSON() const {
+    UniValue histogram(UniValue::VARR);
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        if (!buckets[i]) {
+            continue;
+        }
+        UniValue bucket(UniValue::VOBJ);
+        if (i < BUCKETS - 1) {
+            bucket.pushKV("below", int64_t{1} << i);
+        }
+        bucket.pushKV("count", buckets[i]);
+        histogram.push_back(bucket);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("count", count);
+    ret.pushKV("total", total);
+    ret.pushKV("avg", count ? total / static_cast<int64_t>(count) : 0);
+    ret.pushKV("max", max);
+    ret.pushKV("histogram", histogram);
+    return ret;
+}
+
+UniValue ProcessBlockStats::ToJSON() const {
+    UniValue stagesObj(UniValue::VOBJ);
+    for (const auto &[name, stageTime] : stages) {
+        stagesObj.pushKV(name, stageTime);
+    }
+
+    UniValue txTypesObj(UniValue::VOBJ);
+    for (const auto &[txType, stats] : txTypes) {
+        UniValue txTypeObj(UniValue::VOBJ);
+        txTypeObj.pushKV("count", static_cast<uint64_t>(stats.count));
+        txTypeObj.pushKV("time", stats.time);
+        txTypesObj.pushKV(ToString(txType), txTypeObj);
+    }
+
+    UniValue storageObj(UniValue::VOBJ);
+    storageObj.pushKV("dbreads", storage.dbReads);
+    storageObj.pushKV("prefetchhits", storage.prefetchHits);
+    storageObj.pushKV("decodedhits", storage.decodedHits);
+    storageObj.pushKV("decodedmisses", storage.decodedMisses);
+    storageObj.pushKV("keyswritten", storage.keysWritten);
+    storageObj.pushKV("byteswritten", storage.bytesWritten);
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("height", height);
+    ret.pushKV("hash", hash.GetHex());
+    ret.pushKV("time", time);
+    ret.pushKV("stages", stagesObj);
+    ret.pushKV("customtxs", txTypesObj);
+    ret.pushKV("storage", storageObj);
+    return ret;
+}
+
+static ProcessStorageStats CurrentStorageStats() {
+    ProcessStorageStats stats;
+    stats.dbReads = storageReadStats.reads.load(std::memory_order_relaxed);
+    stats.prefetchHits = storageReadStats.prefetchHits.load(std::memory_order_relaxed);
+    stats.decodedHits = decodedCacheStats.hits.load(std::memory_order_relaxed);
+    stats.decodedMisses = decodedCacheStats.misses.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void CDeFiProcessStats::SetHistorySize(const size_t size) {
+    LOCK(cs_stats);
+    history.set_capacity(size);
+    active.store(size > 0, std::memory_order_relaxed);
+}
+
+void CDeFiProcessStats::BeginBlock(const int height, const uint256 &hash) {
+    if (!IsActive()) {
+        current.reset();
+        return;
+    }
+    current.emplace();
+    current->height = height;
+    current->hash = hash;
+    currentTxTimes.clear();
+    currentStorage = CurrentStorageStats();
+    currentStart = GetTimeMicros();
+}
+
+void CDeFiProcessStats::AddStage(const std::string &name, const int64_t time) {
+    if (!current) {
+        return;
+    }
+    current->stages[name] += time;
+}
+
+void CDeFiProcessStats::AddTx(const CustomTxType txType, const int64_t time) {
+    if (!current) {
+        return;
+    }
+    auto &stats = current->txTypes[txType];
+    ++stats.count;
+    stats.time += time;
+    currentTxTimes.emplace_back(txType, time);
+}
+
+void CDeFiProcessStats::EndBlock(const uint64_t keysWritten, const uint64_t bytesWritten) {
+    if (!current) {
+        return;
+    }
+    current->time = GetTimeMicros() - currentStart;
+
+    // Other readers of the storage during the block are counted as well
+    const auto storage = CurrentStorageStats();
+    current->storage.dbReads = storage.dbReads - currentStorage.dbReads;
+    current->storage.prefetchHits = storage.prefetchHits - currentStorage.prefetchHits;
+    current->storage.decodedHits = storage.decodedHits - currentStorage.decodedHits;
+    current->storage.decodedMisses = storage.decodedMisses - currentStorage.decodedMisses;
+    current->storage.keysWritten = keysWritten;
+    current->storage.bytesWritten = bytesWritten;
+
+    LOCK(cs_stats);
+    for (const auto &[name, stageTime] : current->stages) {
+        stageTimes[name].Add(stageTime);
+    }
+    for (const auto &[txType, txTime] : currentTxTimes) {
+        txTypeTimes[txType].Add(txTime);
+    }
+    if (history.capacity()) {
+        history.push_back(std::move(*current));
+    }
+    current.reset();
+}
+
+UniValue CDeFiProcessStats::ToJSON(const size_t blocks) {
+    LOCK(cs_stats);
+
+    UniValue blocksArr(UniValue::VARR);
+    const auto skip = history.size() > blocks ? history.size() - blocks : 0;
+    for (auto it = history.begin() + skip; it != history.end(); ++it) {
+        blocksArr.push_back(it->ToJSON());
+    }
+
+    UniValue stagesObj(UniValue::VOBJ);
+    for (const auto &[name, histogram] : stageTimes) {
+        stagesObj.pushKV(name, histogram.ToJSON());
+    }
+
+    UniValue txTypesObj(UniValue::VOBJ);
+    for (const auto &[txType, histogram] : txTypeTimes) {
+        txTypesObj.pushKV(ToString(txType), histogram.ToJSON());
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("blocks", blocksArr);
+    ret.pushKV("stages", stagesObj);
+    ret.pushKV("customtxs", txTypesObj);
+    return ret;
+}
+
+CProcessStageTimer::CProcessStageTimer()
+    : start(deFiProcessStats.IsActive() ? GetTimeMicros() : 0) {}
+
+void CProcessStageTimer::Lap(const char *name) {
+    if (!start) {
+        return;
+    }
+    const auto now = GetTimeMicros();
+    deFiProcessStats.AddStage(name, now - start);
+    start = now;
+}
@@ -0,0 +1,107 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_DFI_PROCESSSTATS_H
+#define DEFI_DFI_PROCESSSTATS_H
+
+#include <sync.h>
+#include <uint256.h>
+#include <univalue.h>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/circular_buffer.hpp>
+
+enum class CustomTxType : uint8_t;
+
+static const uint32_t DEFAULT_DEFI_PROCESS_STATS = 100;
+
+// Times in microseconds, bucket i counts the times below 2^i
+struct ProcessTimeHistogram {
+    static constexpr size_t BUCKETS = 24;
+
+    uint64_t count{};
+    int64_t total{};
+    int64_t max{};
+    std::array<uint64_t, BUCKETS> buckets{};
+
+    void Add(const int64_t time);
+    UniValue ToJSON() const;
+};
+
+struct ProcessTxTypeStats {
+    uint32_t count{};
+    int64_t time{};
+};
+
+struct ProcessStorageStats {
+    uint64_t dbReads{};
+    uint64_t prefetchHits{};
+    uint64_t decodedHits{};
+    uint64_t decodedMisses{};
+    uint64_t keysWritten{};
+    uint64_t bytesWritten{};
+};
+
+struct ProcessBlockStats {
+    int height{};
+    uint256 hash;
+    int64_t time{};
+    std::map<std::string, int64_t> stages;
+    std::map<CustomTxType, ProcessTxTypeStats> txTypes;
+    ProcessStorageStats storage;
+
+    UniValue ToJSON() const;
+};
+
+/**
+ * Timings and counters of the DeFi processing of connected blocks. The
+ * current block is only touched by the thread connecting blocks, under
+ * cs_main, the history and histograms are read by the RPC.
+ */
+class CDeFiProcessStats {
+public:
+    // Number of blocks kept, zero turns the stats off
+    void SetHistorySize(const size_t size);
+    bool IsActive() const { return active.load(std::memory_order_relaxed); }
+
+    void BeginBlock(const int height, const uint256 &hash);
+    void AddStage(const std::string &name, const int64_t time);
+    void AddTx(const CustomTxType txType, const int64_t time);
+    void EndBlock(const uint64_t keysWritten, const uint64_t bytesWritten);
+
+    UniValue ToJSON(const size_t blocks);
+
+private:
+    std::atomic_bool active{false};
+    std::optional<ProcessBlockStats> current;
+    int64_t currentStart{};
+    ProcessStorageStats currentStorage;
+    std::vector<std::pair<CustomTxType, int64_t>> currentTxTimes;
+
+    Mutex cs_stats;
+    boost::circular_buffer<ProcessBlockStats> history GUARDED_BY(cs_stats);
+    std::map<std::string, ProcessTimeHistogram> stageTimes GUARDED_BY(cs_stats);
+    std::map<CustomTxType, ProcessTimeHistogram> txTypeTimes GUARDED_BY(cs_stats);
+};
+
+extern CDeFiProcessStats deFiProcessStats;
+
+// Adds the time since the previous lap as a stage of the current block
+class CProcessStageTimer {
+public:
+    CProcessStageTimer();
+    void Lap(const char *name);
+
+private:
+    int64_t start;
+};
+
+#endif  // DEFI_DFI_PROCESSSTATS_H
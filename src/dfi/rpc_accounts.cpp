@@ -2,11 +2,9 @@
 #include <dfi/accountshistory.h>
 #include <dfi/govvariables/attributes.h>
 #include <dfi/mn_rpc.h>
-#include <dfi/threadpool.h>
 #include <dfi/validation.h>
 #include <dfi/vaulthistory.h>
 #include <ffi/ffihelpers.h>
-#include <boost/asio.hpp>
 
 static bool DEFAULT_DVM_OWNERSHIP_CHECK = true;
 
@@ -426,7 +424,7 @@ UniValue listaccounts(const JSONRPCRequest &request) {
         isMineOnly = request.params[3].get_bool();
     }
 
-    UniValue ret(UniValue::VARR);
+    RPCResultArray ret(request);
 
     auto [view, accountView, vaultView] = GetSnapshots();
     auto targetHeight = view->GetLastHeight() + 1;
@@ -457,7 +455,7 @@ UniValue listaccounts(const JSONRPCRequest &request) {
         },
         start.owner);
 
-    return GetRPCResultCache().Set(request, ret);
+    return ret.Finish();
 }
 
 UniValue getaccount(const JSONRPCRequest &request) {
@@ -2534,9 +2532,6 @@ UniValue getburninfo(const JSONRPCRequest &request) {
     if (auto res = GetRPCResultCache().TryGet(request)) {
         return *res;
     }
-    auto initialResult = GetMemoizedResultCache().GetOrDefault(request);
-    auto totalResult = std::get_if<CGetBurnInfoResult>(&initialResult.data);
-
     CAmount dfiPaybackFee{0};
     CAmount burnt{0};
 
@@ -2548,11 +2543,6 @@ UniValue getburninfo(const JSONRPCRequest &request) {
 
     auto [view, accountView, vaultView] = GetSnapshots();
     const auto height = view->GetLastHeight();
-    uint256 hash;
-    {
-        LOCK(cs_main);
-        hash = ::ChainActive().Tip()->GetBlockHash();
-    }
     auto fortCanningHeight = Params().GetConsensus().DF11FortCanningHeight;
     auto burnAddress = Params().GetConsensus().burnAddress;
     const auto attributes = view->GetAttributes();
@@ -2584,133 +2574,21 @@ UniValue getburninfo(const JSONRPCRequest &request) {
         }
     }
 
-    auto nWorkers = DfTxTaskPool->GetAvailableThreads();
-    if (static_cast<size_t>(height) < nWorkers) {
-        nWorkers = height;
-    }
-
-    const auto chunkSize = height / nWorkers;
-
-    TaskGroup g;
-    BufferPool<CGetBurnInfoResult> resultsPool{nWorkers};
-
-    LOCK(cs_main);  // Lock for pburnHistoryDB
-
-    auto &pool = DfTxTaskPool->pool;
-    auto processedHeight = initialResult.height;
-    auto i = 0;
-    while (processedHeight < height) {
-        auto startHeight = initialResult.height + (chunkSize * (i + 1));
-        auto stopHeight = initialResult.height + (chunkSize * (i));
-
-        g.AddTask();
-        boost::asio::post(pool, [startHeight, stopHeight, &g, &resultsPool] {
-            auto currentResult = resultsPool.Acquire();
-
-            pburnHistoryDB->ForEachAccountHistory(
-                [currentResult, stopHeight](const AccountHistoryKey &key, const AccountHistoryValue &value) {
-                    // Stop on chunk range for worker
-                    if (key.blockHeight <= stopHeight) {
-                        return false;
-                    }
-
-                    // UTXO burn
-                    if (value.category == uint8_t(CustomTxType::None)) {
-                        for (auto const &diff : value.diff) {
-                            currentResult->burntDFI += diff.second;
-                        }
-                        return true;
-                    }
-
-                    // Fee burn
-                    if (value.category == uint8_t(CustomTxType::CreateMasternode) ||
-                        value.category == uint8_t(CustomTxType::CreateToken) ||
-                        value.category == uint8_t(CustomTxType::Vault) ||
-                        value.category == uint8_t(CustomTxType::CreateCfp) ||
-                        value.category == uint8_t(CustomTxType::CreateVoc)) {
-                        for (auto const &diff : value.diff) {
-                            currentResult->burntFee += diff.second;
-                        }
-                        return true;
-                    }
-
-                    // withdraw burn
-                    if (value.category == uint8_t(CustomTxType::PaybackLoan) ||
-                        value.category == uint8_t(CustomTxType::PaybackLoanV2) ||
-                        value.category == uint8_t(CustomTxType::PaybackWithCollateral)) {
-                        for (const auto &[id, amount] : value.diff) {
-                            currentResult->paybackFee.Add({id, amount});
-                        }
-                        return true;
-                    }
-
-                    // auction burn
-                    if (value.category == uint8_t(CustomTxType::AuctionBid)) {
-                        for (auto const &diff : value.diff) {
-                            currentResult->auctionFee += diff.second;
-                        }
-                        return true;
-                    }
-
-                    // dex fee burn
-                    if (value.category == uint8_t(CustomTxType::PoolSwap) ||
-                        value.category == uint8_t(CustomTxType::PoolSwapV2)) {
-                        for (auto const &diff : value.diff) {
-                            currentResult->dexfeeburn.Add({diff.first, diff.second});
-                        }
-                        return true;
-                    }
-
-                    // token burn with burnToken tx
-                    if (value.category == uint8_t(CustomTxType::BurnToken)) {
-                        for (auto const &diff : value.diff) {
-                            currentResult->burntTokens.Add({diff.first, diff.second});
-                        }
-                        return true;
-                    }
-
-                    // Token burn
-                    for (auto const &diff : value.diff) {
-                        currentResult->burntTokens.Add({diff.first, diff.second});
-                    }
-
-                    return true;
-                },
-                {},
-                startHeight,
-                std::numeric_limits<uint32_t>::max());
-
-            resultsPool.Release(currentResult);
-            g.RemoveTask();
-        });
-
-        // perfect accuracy: processedHeight += (startHeight > height) ? chunksRemainder : chunkSize;
-        processedHeight += chunkSize;
-        i++;
-    }
-
-    g.WaitForCompletion();
-
-    for (const auto &r : resultsPool.GetBuffer()) {
-        totalResult->burntDFI += r->burntDFI;
-        totalResult->burntFee += r->burntFee;
-        totalResult->auctionFee += r->auctionFee;
-        totalResult->burntTokens.AddBalances(r->burntTokens.balances);
-        totalResult->dexfeeburn.AddBalances(r->dexfeeburn.balances);
-        totalResult->paybackFee.AddBalances(r->paybackFee.balances);
+    BurnHistoryTotals totalResult;
+    {
+        LOCK(cs_main);  // Lock for pburnHistoryDB
+        totalResult = pburnHistoryDB->GetBurnTotals();
     }
 
-    GetMemoizedResultCache().Set(request, {height, hash, *totalResult});
-
     UniValue result(UniValue::VOBJ);
     result.pushKV("address", ScriptToString(burnAddress));
-    result.pushKV("amount", ValueFromAmount(totalResult->burntDFI));
+    result.pushKV("amount", ValueFromAmount(totalResult.burntDFI));
 
-    result.pushKV("tokens", AmountsToJSON(*view, totalResult->burntTokens.balances));
-    result.pushKV("feeburn", ValueFromAmount(totalResult->burntFee));
-    result.pushKV("auctionburn", ValueFromAmount(totalResult->auctionFee));
-    result.pushKV("paybackburn", AmountsToJSON(*view, totalResult->paybackFee.balances));
-    result.pushKV("dexfeetokens", AmountsToJSON(*view, totalResult->dexfeeburn.balances));
+    result.pushKV("tokens", AmountsToJSON(*view, totalResult.burntTokens.balances));
+    result.pushKV("feeburn", ValueFromAmount(totalResult.burntFee));
+    result.pushKV("auctionburn", ValueFromAmount(totalResult.auctionFee));
+    result.pushKV("paybackburn", AmountsToJSON(*view, totalResult.paybackFee.balances));
+    result.pushKV("dexfeetokens", AmountsToJSON(*view, totalResult.dexfeeburn.balances));
 
     result.pushKV("dfipaybackfee", ValueFromAmount(dfiPaybackFee));
     result.pushKV("dfipaybacktokens", AmountsToJSON(*view, dfipaybacktokens.balances));
@@ -1,5 +1,3 @@
-#include <boost/asio.hpp>
-
 #include <dfi/accountshistory.h>
 #include <dfi/govvariables/attributes.h>
 #include <dfi/mn_rpc.h>
@@ -1532,11 +1530,8 @@ UniValue getloaninfo(const JSONRPCRequest &request) {
     auto priceBlocks = GetFixedIntervalPriceBlocks(*view);
 
     TaskGroup g;
-    g.AddTask();
-
-    auto &pool = DfTxTaskPool->pool;
 
-    boost::asio::post(pool, [&, &view = view] {
+    DfTxTaskPool->Post(g, [&, &view = view] {
         view->ForEachLoanScheme([&](const std::string &identifier, const CLoanSchemeData &data) {
             totalLoanSchemes++;
             return true;
@@ -1577,41 +1572,35 @@ UniValue getloaninfo(const JSONRPCRequest &request) {
                 return true;
             },
             height);
-
-        g.RemoveTask();
     });
 
     std::atomic<uint64_t> vaultsTotal{0};
     std::atomic<uint64_t> colsValTotal{0};
     std::atomic<uint64_t> loansValTotal{0};
 
-    view->ForEachVault([&, &view = view](const CVaultId &vaultId, const CVaultData &data) {
-        g.AddTask();
-        boost::asio::post(pool,
-                          [&,
-                           &colsValTotal = colsValTotal,
-                           &loansValTotal = loansValTotal,
-                           &vaultsTotal = vaultsTotal,
-                           vaultId = vaultId,
-                           height = height,
-                           useNextPrice = useNextPrice,
-                           requireLivePrice = requireLivePrice] {
-                              auto collaterals = view->GetVaultCollaterals(vaultId);
-                              if (!collaterals) {
-                                  collaterals = CBalances{};
-                              }
-                              auto rate = view->GetVaultAssets(
-                                  vaultId, *collaterals, height, lastBlockTime, useNextPrice, requireLivePrice);
-                              if (rate) {
-                                  colsValTotal.fetch_add(rate.val->totalCollaterals, std::memory_order_relaxed);
-                                  loansValTotal.fetch_add(rate.val->totalLoans, std::memory_order_relaxed);
-                              }
-                              vaultsTotal.fetch_add(1, std::memory_order_relaxed);
-                              g.RemoveTask();
-                          });
+    std::vector<CVaultId> vaultIds;
+    view->ForEachVault([&](const CVaultId &vaultId, const CVaultData &) {
+        vaultIds.push_back(vaultId);
         return true;
     });
 
+    ParallelFor(vaultIds.size(), 64, [&, &view = view](const size_t begin, const size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            const auto &vaultId = vaultIds[i];
+            auto collaterals = view->GetVaultCollaterals(vaultId);
+            if (!collaterals) {
+                collaterals = CBalances{};
+            }
+            auto rate =
+                view->GetVaultAssets(vaultId, *collaterals, height, lastBlockTime, useNextPrice, requireLivePrice);
+            if (rate) {
+                colsValTotal.fetch_add(rate.val->totalCollaterals, std::memory_order_relaxed);
+                loansValTotal.fetch_add(rate.val->totalLoans, std::memory_order_relaxed);
+            }
+            vaultsTotal.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
     g.WaitForCompletion();
     // We use relaxed ordering to increment. Thread joins should in theory,
     // resolve have resulted in full barriers, but we ensure
@@ -885,53 +885,79 @@ UniValue listlatestrawprices(const JSONRPCRequest &request) {
     return GetRPCResultCache().Set(request, result);
 }
 
+namespace {
+
+    // Weighted average of the live oracle prices of a price feed
+    class CAggregatePrice {
+    public:
+        void Add(const COraclePriceFeedValue &value, uint64_t lastBlockTime) {
+            if (!value.price || !diffInHour(value.price->second, lastBlockTime)) {
+                return;
+            }
+            ++numLiveOracles;
+            sumWeights += value.weightage;
+            weightedSum += arith_uint256(value.price->first) * arith_uint256(value.weightage);
+        }
+
+        ResVal<CAmount> Result() const {
+            static const uint64_t minimumLiveOracles =
+                Params().NetworkIDString() == CBaseChainParams::REGTEST ? 1 : 2;
+            if (numLiveOracles < minimumLiveOracles) {
+                return Res::Err("no live oracles for specified request");
+            }
+            if (sumWeights <= 0) {
+                return Res::Err("all live oracles which meet specified request, have zero weight");
+            }
+            return ResVal<CAmount>((weightedSum / arith_uint256(sumWeights)).GetLow64(), Res::Ok());
+        }
+
+    private:
+        arith_uint256 weightedSum = 0;
+        uint64_t numLiveOracles = 0, sumWeights = 0;
+    };
+
+    bool IsDUSDPriceFeed(const std::string &token, const std::string &currency) {
+        return token == "DUSD" && currency == "USD";
+    }
+}  // namespace
+
 ResVal<CAmount> GetAggregatePrice(CCustomCSView &view,
                                   const std::string &token,
                                   const std::string &currency,
                                   uint64_t lastBlockTime) {
     // DUSD-USD always returns 1.00000000
-    if (token == "DUSD" && currency == "USD") {
+    if (IsDUSDPriceFeed(token, currency)) {
         return ResVal<CAmount>(COIN, Res::Ok());
     }
-    arith_uint256 weightedSum = 0;
-    uint64_t numLiveOracles = 0, sumWeights = 0;
-    view.ForEachOracle([&](const COracleId &, COracle oracle) {
-        if (!oracle.SupportsPair(token, currency)) {
-            return true;
-        }
-        for (const auto &tokenPrice : oracle.tokenPrices) {
-            if (token != tokenPrice.first) {
-                continue;
-            }
-            for (const auto &price : tokenPrice.second) {
-                if (currency != price.first) {
-                    continue;
-                }
-                const auto &pricePair = price.second;
-                auto amount = pricePair.first;
-                auto timestamp = pricePair.second;
-                if (!diffInHour(timestamp, lastBlockTime)) {
-                    continue;
-                }
-                ++numLiveOracles;
-                sumWeights += oracle.weightage;
-                weightedSum += arith_uint256(amount) * arith_uint256(oracle.weightage);
+    const CTokenCurrencyPair priceFeedId{token, currency};
+    CAggregatePrice aggregate;
+    view.ForEachOraclePriceFeed(
+        [&](const COraclePriceFeedKey &key, const COraclePriceFeedValue &value) {
+            if (key.priceFeedId != priceFeedId) {
+                return false;
             }
-        }
+            aggregate.Add(value, lastBlockTime);
+            return true;
+        },
+        {priceFeedId, {}});
+
+    return aggregate.Result();
+}
+
+std::map<CTokenCurrencyPair, ResVal<CAmount>> GetAggregatePrices(CCustomCSView &view, uint64_t lastBlockTime) {
+    std::map<CTokenCurrencyPair, CAggregatePrice> aggregates;
+    view.ForEachOraclePriceFeed([&](const COraclePriceFeedKey &key, const COraclePriceFeedValue &value) {
+        aggregates[key.priceFeedId].Add(value, lastBlockTime);
         return true;
     });
 
-    static const uint64_t minimumLiveOracles = Params().NetworkIDString() == CBaseChainParams::REGTEST ? 1 : 2;
-    if (numLiveOracles < minimumLiveOracles) {
-        return Res::Err("no live oracles for specified request");
+    std::map<CTokenCurrencyPair, ResVal<CAmount>> prices;
+    for (const auto &[priceFeedId, aggregate] : aggregates) {
+        prices.emplace(priceFeedId,
+                       IsDUSDPriceFeed(priceFeedId.first, priceFeedId.second) ? ResVal<CAmount>(COIN, Res::Ok())
+                                                                               : aggregate.Result());
     }
-    if (sumWeights <= 0) {
-        return Res::Err("all live oracles which meet specified request, have zero weight");
-    }
-
-    ResVal<CAmount> res((weightedSum / arith_uint256(sumWeights)).GetLow64(), Res::Ok());
-
-    return res;
+    return prices;
 }
 
 namespace {
@@ -961,25 +987,18 @@ namespace {
         }
 
         UniValue result(UniValue::VARR);
-        std::set<CTokenCurrencyPair> setTokenCurrency;
-        view.ForEachOracle([&](const COracleId &, COracle oracle) {
-            const auto &pairs = oracle.availablePairs;
-            setTokenCurrency.insert(pairs.begin(), pairs.end());
-            return true;
-        });
+        const auto aggregatePrices = GetAggregatePrices(view, lastBlockTime);
 
-        if (start >= setTokenCurrency.size()) {
+        if (start >= aggregatePrices.size()) {
             throw JSONRPCError(RPC_MISC_ERROR, "start index greater than number of prices available");
         }
 
-        for (auto tokenCurrency :
-             std::set<CTokenCurrencyPair>(std::next(setTokenCurrency.begin(), start), setTokenCurrency.end())) {
+        for (auto it = std::next(aggregatePrices.begin(), start); it != aggregatePrices.end(); ++it) {
             UniValue item{UniValue::VOBJ};
-            const auto &token = tokenCurrency.first;
-            const auto &currency = tokenCurrency.second;
+            const auto &[token, currency] = it->first;
             item.pushKV(oraclefields::Token, token);
             item.pushKV(oraclefields::Currency, currency);
-            auto aggregatePrice = GetAggregatePrice(view, token, currency, lastBlockTime);
+            const auto &aggregatePrice = it->second;
             if (aggregatePrice) {
                 item.pushKV(oraclefields::AggregatedPrice, ValueFromAmount(*aggregatePrice.val));
                 item.pushKV(oraclefields::ValidityFlag, oraclefields::FlagIsValid);
@@ -1108,12 +1108,14 @@ UniValue getgovproposal(const JSONRPCRequest &request) {
     }
 
     std::set<uint256> activeMasternodes;
-    view->ForEachMasternode([&, &view = view](const uint256 &mnId, CMasternode node) {
-        if (node.IsActive(targetHeight, *view) && node.mintedBlocks) {
-            activeMasternodes.insert(mnId);
-        }
-        return true;
-    });
+    view->ForEachActiveCandidate(
+        [&, &view = view](const uint256 &mnId, CMasternode node) {
+            if (node.IsActive(targetHeight, *view) && node.mintedBlocks) {
+                activeMasternodes.insert(mnId);
+            }
+            return true;
+        },
+        targetHeight);
 
     if (activeMasternodes.empty()) {
         return proposalToJSON(propId, *prop, std::nullopt);
@@ -615,7 +615,7 @@ UniValue listvaults(const JSONRPCRequest &request) {
         }
     }
 
-    UniValue valueArr{UniValue::VARR};
+    RPCResultArray valueArr(request);
 
     auto [view, accountView, vaultView] = GetSnapshots();
 
@@ -649,7 +649,7 @@ UniValue listvaults(const JSONRPCRequest &request) {
         start,
         ownerAddress);
 
-    return GetRPCResultCache().Set(request, valueArr);
+    return valueArr.Finish();
 }
 
 UniValue getvault(const JSONRPCRequest &request) {
@@ -1240,7 +1240,7 @@ UniValue listauctions(const JSONRPCRequest &request) {
         }
     }
 
-    UniValue valueArr{UniValue::VARR};
+    RPCResultArray valueArr(request);
 
     auto [view, accountView, vaultView] = GetSnapshots();
 
@@ -1256,7 +1256,7 @@ UniValue listauctions(const JSONRPCRequest &request) {
         height,
         vaultId);
 
-    return GetRPCResultCache().Set(request, valueArr);
+    return valueArr.Finish();
 }
 
 UniValue auctionhistoryToJSON(const CCustomCSView &view,
@@ -29,10 +29,18 @@ SnapshotCollection CSnapshotManager::GetSnapshots() {
 std::optional<SnapshotCollection> CSnapshotManager::GetCurrentSnapshots() {
     std::unique_lock lock(mtx);
 
-    if (!currentViewSnapshot || (historyDB && !currentHistorySnapshot) || (vaultDB && !currentVaultSnapshot)) {
+    if (!HasCurrentSnapshots()) {
         return {};
     }
 
+    return CheckoutCurrentSnapshots();
+}
+
+bool CSnapshotManager::HasCurrentSnapshots() const {
+    return currentViewSnapshot && (!historyDB || currentHistorySnapshot) && (!vaultDB || currentVaultSnapshot);
+}
+
+SnapshotCollection CSnapshotManager::CheckoutCurrentSnapshots() {
     auto [changed, snapshotDB] = CheckoutViewSnapshot();
     auto viewSnapshot = std::make_unique<CCustomCSView>(snapshotDB, changed);
 
@@ -56,6 +64,11 @@ SnapshotCollection CSnapshotManager::GetGlobalSnapshots() {
     LOCK(cs_main);
     std::unique_lock lock(mtx);
 
+    // A block may have set them while waiting for the locks
+    if (HasCurrentSnapshots()) {
+        return CheckoutCurrentSnapshots();
+    }
+
     auto [changed, snapshotDB] = GetGlobalViewSnapshot();
     auto viewSnapshot = std::make_unique<CCustomCSView>(snapshotDB, changed);
 
@@ -116,7 +129,7 @@ static void SetCurrentSnapshot(T &db, U &currentSnapshot, SnapshotType type, con
 
         // Set current snapshot
         currentSnapshot = std::make_unique<CBlockSnapshot>(
-            snapshot, MapKV{}, CBlockSnapshotKey{type, block->nHeight, block->GetBlockHash()});
+            snapshot, nullptr, CBlockSnapshotKey{type, block->nHeight, block->GetBlockHash()});
     }
 }
 
@@ -149,7 +162,7 @@ void CSnapshotManager::SetBlockSnapshots(CFlushableStorageKV &viewStorge,
     ::SetCurrentSnapshot(vaultView, currentVaultSnapshot, SnapshotType::VAULT, block);
 }
 
-std::pair<MapKV, std::unique_ptr<CStorageLevelDB>> CSnapshotManager::GetGlobalViewSnapshot() {
+std::pair<std::shared_ptr<const ArenaMapKV>, std::unique_ptr<CStorageLevelDB>> CSnapshotManager::GetGlobalViewSnapshot() {
     // Get database snapshot and flushable storage changed map
     auto [changedMap, snapshot] = pcustomcsview->GetStorage().CreateSnapshotData();
 
@@ -176,7 +189,7 @@ std::unique_ptr<CCheckedOutSnapshot> CSnapshotManager::GetGlobalHistorySnapshot(
     auto globalSnapshot = std::make_unique<CCheckedOutSnapshot>(snapshot, key);
 
     // Set global as current snapshot
-    currentHistorySnapshot = std::make_unique<CBlockSnapshot>(globalSnapshot->GetLevelDBSnapshot(), MapKV{}, key);
+    currentHistorySnapshot = std::make_unique<CBlockSnapshot>(globalSnapshot->GetLevelDBSnapshot(), nullptr, key);
 
     // Track checked out snapshot
     ::CheckoutSnapshot(checkedOutHistoryMap, *currentHistorySnapshot);
@@ -194,7 +207,7 @@ std::unique_ptr<CCheckedOutSnapshot> CSnapshotManager::GetGlobalVaultSnapshot()
     auto globalSnapshot = std::make_unique<CCheckedOutSnapshot>(snapshot, key);
 
     // Set global as current snapshot
-    currentVaultSnapshot = std::make_unique<CBlockSnapshot>(globalSnapshot->GetLevelDBSnapshot(), MapKV{}, key);
+    currentVaultSnapshot = std::make_unique<CBlockSnapshot>(globalSnapshot->GetLevelDBSnapshot(), nullptr, key);
 
     // Track checked out snapshot
     ::CheckoutSnapshot(checkedOutVaultMap, *currentVaultSnapshot);
@@ -203,7 +216,7 @@ std::unique_ptr<CCheckedOutSnapshot> CSnapshotManager::GetGlobalVaultSnapshot()
     return globalSnapshot;
 }
 
-std::pair<MapKV, std::unique_ptr<CStorageLevelDB>> CSnapshotManager::CheckoutViewSnapshot() {
+std::pair<std::shared_ptr<const ArenaMapKV>, std::unique_ptr<CStorageLevelDB>> CSnapshotManager::CheckoutViewSnapshot() {
     // Create checked out snapshot
     auto snapshot =
         std::make_unique<CCheckedOutSnapshot>(currentViewSnapshot->GetLevelDBSnapshot(), currentViewSnapshot->GetKey());
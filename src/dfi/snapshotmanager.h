@@ -1,6 +1,7 @@
 #ifndef DEFI_DFI_SNAPSHOTMANAGER_H
 #define DEFI_DFI_SNAPSHOTMANAGER_H
 
+#include <kvmap.h>
 #include <uint256.h>
 
 #include <map>
@@ -22,9 +23,6 @@ namespace leveldb {
     class Snapshot;
 }
 
-using TBytes = std::vector<unsigned char>;
-using MapKV = std::map<TBytes, std::optional<TBytes>>;
-
 using SnapshotCollection = std::tuple<std::unique_ptr<CCustomCSView>,
                                       std::unique_ptr<CAccountHistoryStorage>,
                                       std::unique_ptr<CVaultHistoryStorage>>;
@@ -64,18 +62,21 @@ struct CBlockSnapshotValue {
 
 class CBlockSnapshot {
     const leveldb::Snapshot *snapshot{};
-    MapKV changed;
+    // Shared with the views checked out, never changed
+    std::shared_ptr<const ArenaMapKV> changed;
     CBlockSnapshotKey key;
 
 public:
-    CBlockSnapshot(const leveldb::Snapshot *otherSnapshot, const MapKV &otherChanged, const CBlockSnapshotKey &otherKey)
+    CBlockSnapshot(const leveldb::Snapshot *otherSnapshot,
+                   std::shared_ptr<const ArenaMapKV> otherChanged,
+                   const CBlockSnapshotKey &otherKey)
         : snapshot(otherSnapshot),
-          changed(otherChanged),
+          changed(std::move(otherChanged)),
           key(otherKey) {}
 
     [[nodiscard]] const leveldb::Snapshot *GetLevelDBSnapshot() const { return snapshot; }
     [[nodiscard]] const CBlockSnapshotKey &GetKey() const { return key; }
-    [[nodiscard]] const MapKV &GetChanged() const { return changed; }
+    [[nodiscard]] const std::shared_ptr<const ArenaMapKV> &GetChanged() const { return changed; }
 };
 
 class CCheckedOutSnapshot {
@@ -129,10 +130,12 @@ public:
 private:
     std::optional<SnapshotCollection> GetCurrentSnapshots();
     SnapshotCollection GetGlobalSnapshots();
-    std::pair<MapKV, std::unique_ptr<CStorageLevelDB>> CheckoutViewSnapshot();
+    bool HasCurrentSnapshots() const;
+    SnapshotCollection CheckoutCurrentSnapshots();
+    std::pair<std::shared_ptr<const ArenaMapKV>, std::unique_ptr<CStorageLevelDB>> CheckoutViewSnapshot();
     std::unique_ptr<CCheckedOutSnapshot> CheckoutHistorySnapshot();
     std::unique_ptr<CCheckedOutSnapshot> CheckoutVaultSnapshot();
-    std::pair<MapKV, std::unique_ptr<CStorageLevelDB>> GetGlobalViewSnapshot();
+    std::pair<std::shared_ptr<const ArenaMapKV>, std::unique_ptr<CStorageLevelDB>> GetGlobalViewSnapshot();
     std::unique_ptr<CCheckedOutSnapshot> GetGlobalHistorySnapshot();
     std::unique_ptr<CCheckedOutSnapshot> GetGlobalVaultSnapshot();
 };
@@ -0,0 +1,242 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <dfi/speculativetx.h>
+
+#include <coins.h>
+#include <dfi/masternodes.h>
+#include <dfi/mn_checks.h>
+#include <dfi/threadpool.h>
+#include <ffi/ffiexports.h>
+#include <logging.h>
+#include <util/system.h>
+#include <util/time.h>
+
+#include <algorithm>
+
+#define MILLI 0.001
+
+ParallelCustomTxMode g_parallel_custom_tx_mode{ParallelCustomTxMode::Off};
+
+std::optional<ParallelCustomTxMode> ParseParallelCustomTxMode(const std::string &mode) {
+    if (mode == "off" || mode == "0") {
+        return ParallelCustomTxMode::Off;
+    }
+    if (mode == "on" || mode == "1") {
+        return ParallelCustomTxMode::On;
+    }
+    if (mode == "shadow") {
+        return ParallelCustomTxMode::Shadow;
+    }
+    return {};
+}
+
+bool IsSpeculativeCustomTxType(const CustomTxType txType, const bool withSwaps) {
+    switch (txType) {
+        case CustomTxType::UtxosToAccount:
+        case CustomTxType::AccountToUtxos:
+        case CustomTxType::AccountToAccount:
+        case CustomTxType::AnyAccountsToAccounts:
+        case CustomTxType::AddPoolLiquidity:
+        case CustomTxType::RemovePoolLiquidity:
+            return true;
+        case CustomTxType::PoolSwap:
+        case CustomTxType::PoolSwapV2:
+            return withSwaps;
+        default:
+            return false;
+    }
+}
+
+// Base of the coins of a speculative tx. The coins of its inputs are copied
+// in ahead, a lookup of any other coin lands here and makes the result
+// unusable instead of filling the cache of the block from a worker.
+class CMissingCoinsView : public CCoinsView {
+public:
+    bool GetCoin(const COutPoint &, Coin &) const override {
+        missed = true;
+        return false;
+    }
+    bool HaveCoin(const COutPoint &) const override {
+        missed = true;
+        return false;
+    }
+
+    mutable bool missed{};
+};
+
+struct CSpeculativeCustomTxs::Result {
+    CMissingCoinsView missingCoins;
+    CCoinsViewCache coins;
+    TransactionContext txCtx;
+    CRecordingStorageKV reads;
+    CCustomCSView view;
+    Res res{Res::Ok()};
+
+    Result(const BlockContext &blockCtx, const TransactionContext &txCtx, CCustomCSView &blockView)
+        : coins(&missingCoins),
+          txCtx(coins, txCtx.GetTransaction(), blockCtx, txCtx.GetTxn()),
+          reads(blockView.GetStorage()),
+          view(reads) {
+        // History is written in block order once the tx is committed
+        view.GetHistoryWriters() = blockView.GetHistoryWriters();
+        view.GetHistoryWriters().SetDeferred(true);
+    }
+};
+
+CSpeculativeCustomTxs::CSpeculativeCustomTxs(const ParallelCustomTxMode mode, CCustomCSView &view)
+    : mode(mode),
+      view(view) {}
+
+CSpeculativeCustomTxs::~CSpeculativeCustomTxs() = default;
+
+void CSpeculativeCustomTxs::Add(BlockContext &blockCtx, TransactionContext &txCtx) {
+    entries.push_back({blockCtx, txCtx});
+}
+
+void CSpeculativeCustomTxs::Execute() {
+    if (mode == ParallelCustomTxMode::Off) {
+        return;
+    }
+
+    const auto withSwaps = !gArgs.GetBoolArg("-oceanarchive", DEFAULT_OCEAN_INDEXER_ENABLED);
+
+    results.resize(entries.size());
+    std::vector<size_t> candidates;
+    for (size_t i{}; i < entries.size(); ++i) {
+        auto &[blockCtx, txCtx] = entries[i];
+        const auto &tx = txCtx.GetTransaction();
+        if (tx.IsCoinBase() || !IsSpeculativeCustomTxType(txCtx.GetTxType(), withSwaps) || !txCtx.GetTxMessage().first) {
+            continue;
+        }
+        // The coins cache of the block fills up on lookups, so each tx gets
+        // a copy of the coins of its inputs and the workers never touch it
+        auto result = std::make_unique<Result>(blockCtx, txCtx, view);
+        const auto &coins = txCtx.GetCoins();
+        const auto missingCoin = std::any_of(tx.vin.begin(), tx.vin.end(), [&](const CTxIn &input) {
+            const auto &coin = coins.AccessCoin(input.prevout);
+            if (coin.IsSpent()) {
+                return true;
+            }
+            result->coins.AddCoin(input.prevout, Coin{coin}, false);
+            return false;
+        });
+        if (missingCoin) {
+            continue;
+        }
+        (void)blockCtx.GetEVMEnabledForBlock();
+        results[i] = std::move(result);
+        candidates.push_back(i);
+    }
+    if (candidates.size() < 2) {
+        results.clear();
+        return;
+    }
+
+    // Decoded objects are shared with the txs through the block view, so
+    // that a tx records one read of them instead of the reads building them
+    (void)view.GetAttributes();
+
+    const auto start = GetTimeMicros();
+    ParallelFor(candidates.size(), 1, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            const auto index = candidates[i];
+            auto &result = results[index];
+            try {
+                BlockContext txBlockCtx{entries[index].blockCtx, result->view};
+                result->res = ApplyCustomTx(txBlockCtx, result->txCtx);
+                if (!result->res || result->missingCoins.missed) {
+                    result.reset();
+                }
+            } catch (...) {
+                // Applied serially later on, which surfaces the error
+                result.reset();
+            }
+        }
+    });
+
+    for (const auto &result : results) {
+        executed += bool(result);
+    }
+    executeTime += GetTimeMicros() - start;
+}
+
+Res CSpeculativeCustomTxs::Apply(const size_t index) {
+    auto &[blockCtx, txCtx] = entries[index];
+    if (index >= results.size() || !results[index]) {
+        return ApplyCustomTx(blockCtx, txCtx);
+    }
+    const auto result = std::move(results[index]);
+
+    auto &storage = view.GetStorage();
+    const auto &changes = result->view.GetStorage().GetRaw();
+
+    // The txs applied since the tx ran may have changed what it read
+    auto start = GetTimeMicros();
+    const auto valid = result->reads.GetReads().Validate(storage);
+    validateTime += GetTimeMicros() - start;
+    committed += valid;
+
+    if (mode == ParallelCustomTxMode::Shadow) {
+        CCustomCSView serialView(view);
+        BlockContext serialCtx{blockCtx, serialView};
+        start = GetTimeMicros();
+        auto res = ApplyCustomTx(serialCtx, txCtx);
+        serialTime += GetTimeMicros() - start;
+        if (valid && (res.ok != result->res.ok || res.code != result->res.code || res.msg != result->res.msg ||
+                      serialView.GetStorage().GetRaw() != changes)) {
+            ++mismatches;
+            LogPrintf("Speculative result of tx %s differs from applying it serially\n",
+                      txCtx.GetTransaction().GetHash().GetHex());
+        }
+        serialView.Flush();
+        return res;
+    }
+
+    if (!valid) {
+        return ApplyCustomTx(blockCtx, txCtx);
+    }
+
+    TBytes key;
+    for (const auto &[changedKey, value] : changes) {
+        key.assign(changedKey.begin(), changedKey.end());
+        if (value) {
+            storage.Write(key, *value);
+        } else {
+            storage.Erase(key);
+        }
+    }
+    result->view.GetHistoryWriters().FlushDeferred();
+    txCtx.GetTxMessage() = std::move(result->txCtx.GetTxMessage());
+    return result->res;
+}
+
+void CSpeculativeCustomTxs::LogStats(const std::string &name) const {
+    if (!executed) {
+        return;
+    }
+    // Shadow mode times the serial run of the same txs, which tells whether
+    // running them ahead pays off
+    if (mode == ParallelCustomTxMode::Shadow) {
+        LogPrint(BCLog::BENCH,
+                 "    - Speculative custom txs of %s: %u executed, %u valid, %u mismatched, "
+                 "speculative %.2fms (run %.2fms, validate %.2fms), serial %.2fms\n",
+                 name,
+                 executed,
+                 committed,
+                 mismatches,
+                 (executeTime + validateTime) * MILLI,
+                 executeTime * MILLI,
+                 validateTime * MILLI,
+                 serialTime * MILLI);
+    } else {
+        LogPrint(BCLog::BENCH,
+                 "    - Speculative custom txs of %s: %u executed, %u committed, run %.2fms, validate %.2fms\n",
+                 name,
+                 executed,
+                 committed,
+                 executeTime * MILLI,
+                 validateTime * MILLI);
+    }
+}
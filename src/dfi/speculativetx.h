@@ -0,0 +1,79 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_DFI_SPECULATIVETX_H
+#define DEFI_DFI_SPECULATIVETX_H
+
+#include <dfi/res.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+class BlockContext;
+class CCustomCSView;
+class TransactionContext;
+enum class CustomTxType : uint8_t;
+
+enum class ParallelCustomTxMode : uint8_t {
+    Off,
+    On,
+    // Applies every tx serially and logs where the speculative result differs
+    Shadow,
+};
+
+static const char *const DEFAULT_PARALLEL_CUSTOM_TX = "off";
+
+extern ParallelCustomTxMode g_parallel_custom_tx_mode;
+
+std::optional<ParallelCustomTxMode> ParseParallelCustomTxMode(const std::string &mode);
+
+// Whether the tx type only touches balances and pools, its result then only
+// depends on what it reads and on the height. Swaps are left out when they
+// hand their result to the ocean indexer while they run.
+bool IsSpeculativeCustomTxType(const CustomTxType txType, const bool withSwaps);
+
+// Runs account and pool txs in parallel, each one on its own view of the
+// state before any of them, recording what it reads. The txs are then
+// applied in order: a tx whose reads give the same results on the view is
+// committed as it ran, any other one is applied again.
+class CSpeculativeCustomTxs {
+public:
+    CSpeculativeCustomTxs(const ParallelCustomTxMode mode, CCustomCSView &view);
+    ~CSpeculativeCustomTxs();
+
+    // Adds the next tx, the contexts must outlive this object
+    void Add(BlockContext &blockCtx, TransactionContext &txCtx);
+    void Execute();
+
+    // Same as ApplyCustomTx for the tx at index, txs have to be
+    // applied in the order they were added. Skipping one is fine.
+    Res Apply(const size_t index);
+
+    void LogStats(const std::string &name) const;
+
+private:
+    struct Entry {
+        BlockContext &blockCtx;
+        TransactionContext &txCtx;
+    };
+    struct Result;
+
+    const ParallelCustomTxMode mode;
+    CCustomCSView &view;
+    std::vector<Entry> entries;
+    std::vector<std::unique_ptr<Result>> results;
+
+    uint32_t executed{};
+    uint32_t committed{};
+    uint32_t mismatches{};
+    // Microseconds spent running the txs ahead, validating their reads, and
+    // in shadow mode applying them serially
+    int64_t executeTime{};
+    int64_t validateTime{};
+    int64_t serialTime{};
+};
+
+#endif  // DEFI_DFI_SPECULATIVETX_H
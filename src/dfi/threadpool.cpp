@@ -2,13 +2,163 @@
 
 #include <logging.h>
 #include <util/system.h>
+#include <util/threadnames.h>
+
+static thread_local const TaskPool *currentPool{};
+static thread_local size_t currentWorker{};
 
 TaskPool::TaskPool(size_t size)
-    : pool{size},
-      size{size} {}
+    : size{size} {
+    for (size_t i = 0; i < size; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < size; i++) {
+        threads.emplace_back([this, i] {
+            util::ThreadRename(strprintf("dftx-%d", i));
+            Work(i);
+        });
+    }
+}
+
+TaskPool::~TaskPool() {
+    Shutdown();
+}
 
 void TaskPool::Shutdown() {
-    pool.wait();
+    {
+        std::unique_lock l{sleepMutex};
+        stopping = true;
+    }
+    sleepCv.notify_all();
+    for (auto &thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void TaskPool::Post(std::function<void()> task) {
+    if (IsWorker()) {
+        Push(currentWorker, std::move(task));
+    } else {
+        Push(nextQueue.fetch_add(1, std::memory_order_relaxed) % size, std::move(task));
+    }
+}
+
+void TaskPool::PostBatch(std::vector<std::function<void()>> tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+    {
+        // Queued in the same critical section as the stopping check, so
+        // the workers can't exit in between and leave the tasks behind
+        std::unique_lock l{sleepMutex};
+        if (stopping) {
+            l.unlock();
+            for (auto &task : tasks) {
+                Run(task);
+            }
+            return;
+        }
+        const auto first = IsWorker() ? currentWorker : nextQueue.fetch_add(tasks.size(), std::memory_order_relaxed);
+        for (size_t i = 0; i < size && i < tasks.size(); i++) {
+            auto &queue = *queues[(first + i) % size];
+            std::unique_lock ql{queue.m};
+            for (auto j = i; j < tasks.size(); j += size) {
+                queue.tasks.push_back(std::move(tasks[j]));
+            }
+        }
+        pending.fetch_add(tasks.size(), std::memory_order_release);
+    }
+    sleepCv.notify_all();
+}
+
+void TaskPool::WaitForCompletion(TaskGroup &group) {
+    if (!IsWorker()) {
+        group.WaitForCompletion();
+        return;
+    }
+    // Runs queued tasks until there is nothing left to steal, the rest of
+    // the group is running on other threads then
+    std::function<void()> task;
+    while (!group.IsCompleted() && Pop(currentWorker, task)) {
+        Run(task);
+    }
+    group.WaitForCompletion();
+}
+
+void TaskPool::Push(size_t index, std::function<void()> task) {
+    {
+        std::unique_lock l{sleepMutex};
+        if (stopping) {
+            l.unlock();
+            // No workers left to run it
+            Run(task);
+            return;
+        }
+        auto &queue = *queues[index];
+        std::unique_lock ql{queue.m};
+        queue.tasks.push_back(std::move(task));
+        pending.fetch_add(1, std::memory_order_release);
+    }
+    sleepCv.notify_one();
+}
+
+bool TaskPool::Pop(size_t index, std::function<void()> &task) {
+    {
+        auto &queue = *queues[index];
+        std::unique_lock l{queue.m};
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            pending.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+    for (size_t i = 1; i < size; i++) {
+        auto &queue = *queues[(index + i) % size];
+        std::unique_lock l{queue.m};
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            pending.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskPool::Run(std::function<void()> &task) {
+    // Tasks posted without a group have nobody to report a failure to
+    try {
+        task();
+    } catch (const std::exception &e) {
+        LogPrintf("DfTxTaskPool: Task failed: %s\n", e.what());
+    } catch (...) {
+        LogPrintf("DfTxTaskPool: Task failed\n");
+    }
+    task = nullptr;
+}
+
+bool TaskPool::IsWorker() const {
+    return currentPool == this;
+}
+
+void TaskPool::Work(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    std::function<void()> task;
+    while (true) {
+        if (Pop(index, task)) {
+            Run(task);
+            continue;
+        }
+        std::unique_lock l{sleepMutex};
+        sleepCv.wait(l, [&] { return pending.load(std::memory_order_acquire) > 0 || stopping; });
+        if (stopping && pending.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
 }
 
 void InitDfTxGlobalTaskPool() {
@@ -36,22 +186,42 @@ void TaskGroup::AddTask() {
 }
 
 void TaskGroup::RemoveTask() {
+    // The last task notifies under the lock, so the waiter can neither miss
+    // the wakeup nor release the group before the notification is done
+    std::unique_lock<std::mutex> l(cv_m);
     if (tasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
         cv.notify_all();
     }
 }
 
-void TaskGroup::WaitForCompletion(bool checkForPrematureCompletion) {
-    if (checkForPrematureCompletion && tasks.load() == 0) {
-        return;
+void TaskGroup::SetFailed(std::exception_ptr error) {
+    {
+        std::unique_lock<std::mutex> l(cv_m);
+        if (!this->error) {
+            this->error = error;
+        }
     }
+    MarkCancelled();
+}
+
+void TaskGroup::Wait() {
+    // Checked under the lock only, the last task may still be notifying
     std::unique_lock<std::mutex> l(cv_m);
     cv.wait(l, [&] { return tasks.load() == 0; });
 }
 
-void TaskGroup::EnsureCompletedOrCancelled(bool checkForPrematureCompletion) {
+void TaskGroup::WaitForCompletion() {
+    Wait();
+    std::unique_lock<std::mutex> l(cv_m);
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void TaskGroup::EnsureCompletedOrCancelled() {
     MarkCancelled();
-    WaitForCompletion(checkForPrematureCompletion);
+    // Doesn't throw, a failure of a task that nobody waited for is dropped
+    Wait();
 }
 
 std::unique_ptr<TaskPool> DfTxTaskPool;
@@ -2,44 +2,34 @@
 #define DEFI_DFI_THREADPOOL_H
 
 #include <sync.h>
+
+#include <algorithm>
 #include <atomic>
-#include <boost/asio.hpp>
 #include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
 
 static const int DEFAULT_DFTX_WORKERS = 0;
 static const int DEFAULT_ECC_PRECACHE_WORKERS = -1;
 
-// Until C++20x concurrency impls make it into standard, std::future and std::async impls
-// doesn't have the primitives needed for working with many at the same time efficiently
-// So, for now, we use a queue based approach for the thread pool
-
-// Simple boost thread pool with N threads that's kept around for now
-// Additionally, later task pool can abstract task group entirely, by
-// forwarding the post args into Post method of a child group created
-// from the TaskPool
-
-class TaskPool {
-public:
-    explicit TaskPool(size_t size);
-    void Shutdown();
-    [[nodiscard]] size_t GetAvailableThreads() const { return size; }
-    boost::asio::thread_pool pool;
-
-private:
-    size_t size;
-};
-
-void InitDfTxGlobalTaskPool();
-void ShutdownDfTxGlobalTaskPool();
-
 class TaskGroup {
 public:
     void AddTask();
     void RemoveTask();
-    void WaitForCompletion(bool checkForPrematureCompletion = true);
+    // Waits for the tasks and rethrows the first exception of one of them
+    void WaitForCompletion();
+    // Keeps the first exception of a task and cancels the rest
+    void SetFailed(std::exception_ptr error);
     void MarkCancelled() { is_cancelled.store(true); }
     bool IsCancelled() { return is_cancelled.load(); }
-    void EnsureCompletedOrCancelled(bool checkForPrematureCompletion = true);
+    [[nodiscard]] bool IsCompleted() const { return tasks.load() == 0; }
+    void EnsureCompletedOrCancelled();
     void SetLeak(bool val = true) { is_leaked.store(val); }
 
     TaskGroup() = default;
@@ -47,47 +37,171 @@ public:
 
     ~TaskGroup() {
         if (!is_leaked.load()) {
-            EnsureCompletedOrCancelled(true);
+            EnsureCompletedOrCancelled();
         }
     }
 
 private:
+    void Wait();
+
     std::atomic<uint64_t> tasks{0};
+    std::exception_ptr error;
     std::mutex cv_m;
     std::condition_variable cv;
     std::atomic_bool is_cancelled{false};
     std::atomic_bool is_leaked{false};
 };
 
-template <typename T>
-class BufferPool {
-public:
-    explicit BufferPool(size_t size) {
-        pool.reserve(size);
-        for (size_t i = 0; i < size; i++) {
-            pool.push_back(std::make_shared<T>());
-        }
-    }
+// Work stealing pool with N threads. Every worker owns a deque: tasks posted
+// from a worker go to the back of its own deque and are taken LIFO, tasks
+// posted from elsewhere are spread over the deques, and idle workers steal
+// from the front of the others.
 
-    std::shared_ptr<T> Acquire() {
-        std::unique_lock l{m};
-        auto res = pool.back();
-        pool.pop_back();
-        return res;
-    }
+class TaskPool {
+public:
+    explicit TaskPool(size_t size);
+    ~TaskPool();
+    void Shutdown();
+    [[nodiscard]] size_t GetAvailableThreads() const { return size; }
 
-    void Release(std::shared_ptr<T> res) {
-        std::unique_lock l{m};
-        pool.push_back(res);
+    void Post(std::function<void()> task);
+    // Queues the tasks taking every deque lock once
+    void PostBatch(std::vector<std::function<void()>> tasks);
+
+    // Queues a task of the group, it's skipped once the group is cancelled
+    template <typename F>
+    void Post(TaskGroup &group, F &&task) {
+        group.AddTask();
+        Post([&group, task = std::forward<F>(task)]() mutable {
+            if (!group.IsCancelled()) {
+                try {
+                    task();
+                } catch (...) {
+                    group.SetFailed(std::current_exception());
+                }
+            }
+            group.RemoveTask();
+        });
     }
 
-    std::vector<std::shared_ptr<T>> &GetBuffer() { return pool; }
+    // Waits for the group, a worker keeps running queued tasks meanwhile
+    // so that nested waits can't starve the pool
+    void WaitForCompletion(TaskGroup &group);
 
 private:
-    AtomicMutex m{};
-    std::vector<std::shared_ptr<T>> pool;
+    struct WorkerQueue {
+        AtomicMutex m;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void Push(size_t index, std::function<void()> task);
+    static void Run(std::function<void()> &task);
+    bool Pop(size_t index, std::function<void()> &task);
+    bool IsWorker() const;
+    void Work(size_t index);
+
+    size_t size;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> nextQueue{0};
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
+    bool stopping{false};
 };
 
+void InitDfTxGlobalTaskPool();
+void ShutdownDfTxGlobalTaskPool();
+
 extern std::unique_ptr<TaskPool> DfTxTaskPool;
 
+// Calls fn(begin, end) over [0, count) in chunks of grain items on the DfTx
+// pool. The calling thread takes chunks as well, at most maxWorkers threads
+// work on it when set. Runs inline when the pool isn't available.
+// The caller only waits for the helpers that took a chunk: a helper that
+// starts once all chunks are taken returns right away, so a busy pool
+// doesn't hold up a loop that is done already.
+template <typename F>
+void ParallelFor(size_t count, size_t grain, F &&fn, size_t maxWorkers = 0) {
+    if (!count) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    const auto chunks = (count + grain - 1) / grain;
+    size_t helpers = DfTxTaskPool ? std::min(chunks - 1, DfTxTaskPool->GetAvailableThreads()) : 0;
+    if (maxWorkers) {
+        helpers = std::min(helpers, maxWorkers - 1);
+    }
+
+    // Outlives the call for the helpers that start late
+    struct State {
+        std::atomic<size_t> next{0};
+        std::mutex m;
+        std::condition_variable cv;
+        size_t active{0};
+        bool closed{false};
+        std::exception_ptr error;
+    };
+    const auto state = std::make_shared<State>();
+    auto work = [&] {
+        try {
+            for (size_t chunk; (chunk = state->next.fetch_add(1, std::memory_order_relaxed)) < chunks;) {
+                const auto begin = chunk * grain;
+                fn(begin, std::min(begin + grain, count));
+            }
+        } catch (...) {
+            std::unique_lock l{state->m};
+            if (!state->error) {
+                state->error = std::current_exception();
+            }
+            state->next.store(chunks, std::memory_order_relaxed);
+        }
+    };
+
+    if (helpers) {
+        std::vector<std::function<void()>> tasks;
+        tasks.reserve(helpers);
+        for (size_t i = 0; i < helpers; ++i) {
+            // The caller's frame is only touched after joining the loop
+            tasks.emplace_back([state, chunks, work = &work] {
+                {
+                    std::unique_lock l{state->m};
+                    if (state->closed || state->next.load(std::memory_order_relaxed) >= chunks) {
+                        return;
+                    }
+                    ++state->active;
+                }
+                (*work)();
+                std::unique_lock l{state->m};
+                if (--state->active == 0) {
+                    state->cv.notify_all();
+                }
+            });
+        }
+        DfTxTaskPool->PostBatch(std::move(tasks));
+        work();
+        std::unique_lock l{state->m};
+        state->closed = true;
+        state->cv.wait(l, [&] { return state->active == 0; });
+    } else {
+        work();
+    }
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+// Maps the chunks of [0, count) in parallel and folds the results in chunk
+// order, so the result doesn't depend on the scheduling.
+template <typename T, typename Map, typename Reduce>
+T ParallelReduce(size_t count, size_t grain, T init, Map &&map, Reduce &&reduce) {
+    grain = std::max<size_t>(grain, 1);
+    std::vector<std::optional<T>> partials((count + grain - 1) / grain);
+    ParallelFor(count, grain, [&](size_t begin, size_t end) { partials[begin / grain] = map(begin, end); });
+    for (auto &partial : partials) {
+        init = reduce(std::move(init), std::move(*partial));
+    }
+    return init;
+}
+
 #endif  // DEFI_DFI_THREADPOOL_H
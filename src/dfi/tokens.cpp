@@ -22,7 +22,10 @@ const DCT_ID CTokensView::DCT_ID_START = DCT_ID{128};
 extern const std::string CURRENCY_UNIT;
 
 std::optional<CTokensView::CTokenImpl> CTokensView::GetToken(DCT_ID id) const {
-    return ReadBy<ID, CTokenImpl>(id);
+    if (const auto token = ReadCachedBy<ID, CTokenImpl>(id)) {
+        return *token;
+    }
+    return {};
 }
 
 std::optional<CTokensView::TokenIDPair> CTokensView::GetToken(const std::string &symbolKey) const {
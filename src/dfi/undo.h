@@ -27,10 +27,10 @@ struct UndoKey {
 struct CUndo {
     MapKV before;
 
-    static CUndo Construct(const CStorageKV &before, const MapKV &diff) {
+    static CUndo Construct(const CStorageKV &before, const ArenaMapKV &diff) {
         CUndo result;
         for (const auto &kv : diff) {
-            const auto &beforeKey = kv.first;
+            const auto beforeKey = FromKeyBytes(kv.first);
             TBytes beforeVal;
             if (before.Read(beforeKey, beforeVal)) {
                 result.before[beforeKey] = std::move(beforeVal);
@@ -41,6 +41,26 @@ struct CUndo {
         return result;
     }
 
+    // Same bytes as the serialized Construct result, written entry by entry
+    // without building the before map
+    static TBytes ConstructRaw(const CStorageKV &before, const ArenaMapKV &diff) {
+        TBytes result;
+        CVectorWriter stream(SER_DISK, CLIENT_VERSION, result, 0);
+        WriteCompactSize(stream, diff.size());
+        TBytes beforeKey, beforeVal;
+        for (const auto &kv : diff) {
+            beforeKey.assign(kv.first.begin(), kv.first.end());
+            stream << beforeKey;
+            if (before.Read(beforeKey, beforeVal)) {
+                ser_writedata8(stream, 1);
+                stream << beforeVal;
+            } else {
+                ser_writedata8(stream, 0);
+            }
+        }
+        return result;
+    }
+
     static void Revert(CStorageKV &after, const CUndo &undo) {
         for (const auto &kv : undo.before) {
             if (kv.second) {
@@ -51,6 +71,22 @@ struct CUndo {
         }
     }
 
+    // Reverts from the serialized undo, decoding one entry at a time
+    static void Revert(CStorageKV &after, TBytesView undo) {
+        SpanReader stream(SER_DISK, CLIENT_VERSION, undo);
+        TBytes key;
+        std::optional<TBytes> value;
+        for (auto size = ReadCompactSize(stream); size; --size) {
+            stream >> key;
+            ::Unserialize(stream, value);
+            if (value) {
+                after.Write(key, *value);
+            } else {
+                after.Erase(key);
+            }
+        }
+    }
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
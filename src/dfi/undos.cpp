@@ -14,6 +14,15 @@ Res CUndosView::SetUndo(const UndoKey &key, const CUndo &undo) {
     return Res::Ok();
 }
 
+Res CUndosView::SetUndoRaw(const UndoKey &key, const TBytes &undo) {
+    DB().Write(DbTypeToBytes(std::make_pair(ByUndoKey::prefix(), key)), undo);
+    return Res::Ok();
+}
+
+bool CUndosView::GetUndoRaw(const UndoKey &key, TBytes &undo) const {
+    return DB().Read(DbTypeToBytes(std::make_pair(ByUndoKey::prefix(), key)), undo);
+}
+
 Res CUndosView::DelUndo(const UndoKey &key) {
     EraseBy<ByUndoKey>(key);
     return Res::Ok();
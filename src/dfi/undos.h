@@ -15,6 +15,8 @@ public:
 
     std::optional<CUndo> GetUndo(const UndoKey &key) const;
     Res SetUndo(const UndoKey &key, const CUndo &undo);
+    Res SetUndoRaw(const UndoKey &key, const TBytes &undo);
+    bool GetUndoRaw(const UndoKey &key, TBytes &undo) const;
     Res DelUndo(const UndoKey &key);
 
     // tags
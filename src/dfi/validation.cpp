@@ -16,6 +16,7 @@
 #include <dfi/masternodes.h>
 #include <dfi/mn_checks.h>
 #include <dfi/mn_rpc.h>
+#include <dfi/processstats.h>
 #include <dfi/threadpool.h>
 #include <dfi/validation.h>
 #include <dfi/vaulthistory.h>
@@ -25,7 +26,6 @@
 #include <validation.h>
 
 #include <consensus/params.h>
-#include <boost/asio.hpp>
 
 #define MILLI 0.001
 
@@ -273,169 +273,160 @@ static void ProcessICXEvents(const CBlockIndex *pindex, CCustomCSView &cache, co
 
     bool isPreEunosPaya = pindex->nHeight < consensus.DF10EunosPayaHeight;
 
-    cache.ForEachICXOrderExpire(
-        [&](const CICXOrderView::StatusKey &key, uint8_t status) {
-            if (static_cast<int>(key.first) != pindex->nHeight) {
-                return false;
-            }
+    // Rewards of an owner are brought up to the block height once
+    std::set<CScript> rewardedOwners;
+    auto calculateOwnerRewards = [&](const CScript &owner) {
+        if (rewardedOwners.insert(owner).second) {
+            cache.CalculateOwnerRewards(owner, pindex->nHeight);
+        }
+    };
 
-            auto order = cache.GetICXOrderByCreationTx(key.second);
-            if (!order) {
-                return true;
-            }
+    auto expireOrder = [&](const uint256 &txid, uint8_t status) {
+        auto order = cache.GetICXOrderByCreationTx(txid);
+        if (!order) {
+            return;
+        }
 
-            if (order->orderType == CICXOrder::TYPE_INTERNAL) {
-                CTokenAmount amount{order->idToken, order->amountToFill};
-                CScript txidaddr(order->creationTx.begin(), order->creationTx.end());
-                auto res = cache.SubBalance(txidaddr, amount);
-                if (!res) {
-                    LogPrintf(
-                        "Can't subtract balance from order (%s) txidaddr: %s\n", order->creationTx.GetHex(), res.msg);
-                } else {
-                    cache.CalculateOwnerRewards(order->ownerAddress, pindex->nHeight);
-                    cache.AddBalance(order->ownerAddress, amount);
-                }
+        if (order->orderType == CICXOrder::TYPE_INTERNAL) {
+            CTokenAmount amount{order->idToken, order->amountToFill};
+            CScript txidaddr(order->creationTx.begin(), order->creationTx.end());
+            auto res = cache.SubBalance(txidaddr, amount);
+            if (!res) {
+                LogPrintf("Can't subtract balance from order (%s) txidaddr: %s\n", order->creationTx.GetHex(), res.msg);
+            } else {
+                calculateOwnerRewards(order->ownerAddress);
+                cache.AddBalance(order->ownerAddress, amount);
             }
+        }
 
-            cache.ICXCloseOrderTx(*order, status);
-
-            return true;
-        },
-        pindex->nHeight);
-
-    cache.ForEachICXMakeOfferExpire(
-        [&](const CICXOrderView::StatusKey &key, uint8_t status) {
-            if (static_cast<int>(key.first) != pindex->nHeight) {
-                return false;
-            }
+        cache.ICXCloseOrderTx(*order, status);
+    };
 
-            auto offer = cache.GetICXMakeOfferByCreationTx(key.second);
-            if (!offer) {
-                return true;
-            }
+    auto expireMakeOffer = [&](const uint256 &txid, uint8_t status) {
+        auto offer = cache.GetICXMakeOfferByCreationTx(txid);
+        if (!offer) {
+            return;
+        }
 
-            auto order = cache.GetICXOrderByCreationTx(offer->orderTx);
-            if (!order) {
-                return true;
-            }
+        auto order = cache.GetICXOrderByCreationTx(offer->orderTx);
+        if (!order) {
+            return;
+        }
 
-            CScript txidAddr(offer->creationTx.begin(), offer->creationTx.end());
-            CTokenAmount takerFee{DCT_ID{0}, offer->takerFee};
+        CScript txidAddr(offer->creationTx.begin(), offer->creationTx.end());
+        CTokenAmount takerFee{DCT_ID{0}, offer->takerFee};
 
-            if ((order->orderType == CICXOrder::TYPE_INTERNAL &&
-                 !cache.ExistedICXSubmitDFCHTLC(offer->creationTx, isPreEunosPaya)) ||
-                (order->orderType == CICXOrder::TYPE_EXTERNAL &&
-                 !cache.ExistedICXSubmitEXTHTLC(offer->creationTx, isPreEunosPaya))) {
-                auto res = cache.SubBalance(txidAddr, takerFee);
-                if (!res) {
-                    LogPrintf(
-                        "Can't subtract takerFee from offer (%s) txidAddr: %s\n", offer->creationTx.GetHex(), res.msg);
-                } else {
-                    cache.CalculateOwnerRewards(offer->ownerAddress, pindex->nHeight);
-                    cache.AddBalance(offer->ownerAddress, takerFee);
-                }
+        if ((order->orderType == CICXOrder::TYPE_INTERNAL &&
+             !cache.ExistedICXSubmitDFCHTLC(offer->creationTx, isPreEunosPaya)) ||
+            (order->orderType == CICXOrder::TYPE_EXTERNAL &&
+             !cache.ExistedICXSubmitEXTHTLC(offer->creationTx, isPreEunosPaya))) {
+            auto res = cache.SubBalance(txidAddr, takerFee);
+            if (!res) {
+                LogPrintf(
+                    "Can't subtract takerFee from offer (%s) txidAddr: %s\n", offer->creationTx.GetHex(), res.msg);
+            } else {
+                calculateOwnerRewards(offer->ownerAddress);
+                cache.AddBalance(offer->ownerAddress, takerFee);
             }
+        }
 
-            cache.ICXCloseMakeOfferTx(*offer, status);
-
-            return true;
-        },
-        pindex->nHeight);
-
-    cache.ForEachICXSubmitDFCHTLCExpire(
-        [&](const CICXOrderView::StatusKey &key, uint8_t status) {
-            if (static_cast<int>(key.first) != pindex->nHeight) {
-                return false;
-            }
+        cache.ICXCloseMakeOfferTx(*offer, status);
+    };
 
-            auto dfchtlc = cache.GetICXSubmitDFCHTLCByCreationTx(key.second);
-            if (!dfchtlc) {
-                return true;
-            }
+    auto expireSubmitDFCHTLC = [&](const uint256 &txid, uint8_t status) {
+        auto dfchtlc = cache.GetICXSubmitDFCHTLCByCreationTx(txid);
+        if (!dfchtlc) {
+            return;
+        }
 
-            auto offer = cache.GetICXMakeOfferByCreationTx(dfchtlc->offerTx);
-            if (!offer) {
-                return true;
-            }
+        auto offer = cache.GetICXMakeOfferByCreationTx(dfchtlc->offerTx);
+        if (!offer) {
+            return;
+        }
 
-            auto order = cache.GetICXOrderByCreationTx(offer->orderTx);
-            if (!order) {
-                return true;
-            }
+        auto order = cache.GetICXOrderByCreationTx(offer->orderTx);
+        if (!order) {
+            return;
+        }
 
-            bool refund = false;
+        bool refund = false;
 
-            if (status == CICXSubmitDFCHTLC::STATUS_EXPIRED && order->orderType == CICXOrder::TYPE_INTERNAL) {
-                if (!cache.ExistedICXSubmitEXTHTLC(dfchtlc->offerTx, isPreEunosPaya)) {
-                    CTokenAmount makerDeposit{DCT_ID{0}, offer->takerFee};
-                    cache.CalculateOwnerRewards(order->ownerAddress, pindex->nHeight);
-                    cache.AddBalance(order->ownerAddress, makerDeposit);
-                    refund = true;
-                }
-            } else if (status == CICXSubmitDFCHTLC::STATUS_REFUNDED) {
+        if (status == CICXSubmitDFCHTLC::STATUS_EXPIRED && order->orderType == CICXOrder::TYPE_INTERNAL) {
+            if (!cache.ExistedICXSubmitEXTHTLC(dfchtlc->offerTx, isPreEunosPaya)) {
+                CTokenAmount makerDeposit{DCT_ID{0}, offer->takerFee};
+                calculateOwnerRewards(order->ownerAddress);
+                cache.AddBalance(order->ownerAddress, makerDeposit);
                 refund = true;
             }
+        } else if (status == CICXSubmitDFCHTLC::STATUS_REFUNDED) {
+            refund = true;
+        }
 
-            if (refund) {
-                CScript ownerAddress;
-                if (order->orderType == CICXOrder::TYPE_INTERNAL) {
-                    ownerAddress = CScript(order->creationTx.begin(), order->creationTx.end());
-                } else if (order->orderType == CICXOrder::TYPE_EXTERNAL) {
-                    ownerAddress = offer->ownerAddress;
-                }
-
-                CTokenAmount amount{order->idToken, dfchtlc->amount};
-                CScript txidaddr = CScript(dfchtlc->creationTx.begin(), dfchtlc->creationTx.end());
-                auto res = cache.SubBalance(txidaddr, amount);
-                if (!res) {
-                    LogPrintf("Can't subtract balance from dfc htlc (%s) txidaddr: %s\n",
-                              dfchtlc->creationTx.GetHex(),
-                              res.msg);
-                } else {
-                    cache.CalculateOwnerRewards(ownerAddress, pindex->nHeight);
-                    cache.AddBalance(ownerAddress, amount);
-                }
-
-                cache.ICXCloseDFCHTLC(*dfchtlc, status);
+        if (refund) {
+            CScript ownerAddress;
+            if (order->orderType == CICXOrder::TYPE_INTERNAL) {
+                ownerAddress = CScript(order->creationTx.begin(), order->creationTx.end());
+            } else if (order->orderType == CICXOrder::TYPE_EXTERNAL) {
+                ownerAddress = offer->ownerAddress;
             }
 
-            return true;
-        },
-        pindex->nHeight);
-
-    cache.ForEachICXSubmitEXTHTLCExpire(
-        [&](const CICXOrderView::StatusKey &key, uint8_t status) {
-            if (static_cast<int>(key.first) != pindex->nHeight) {
-                return false;
+            CTokenAmount amount{order->idToken, dfchtlc->amount};
+            CScript txidaddr = CScript(dfchtlc->creationTx.begin(), dfchtlc->creationTx.end());
+            auto res = cache.SubBalance(txidaddr, amount);
+            if (!res) {
+                LogPrintf(
+                    "Can't subtract balance from dfc htlc (%s) txidaddr: %s\n", dfchtlc->creationTx.GetHex(), res.msg);
+            } else {
+                calculateOwnerRewards(ownerAddress);
+                cache.AddBalance(ownerAddress, amount);
             }
 
-            auto exthtlc = cache.GetICXSubmitEXTHTLCByCreationTx(key.second);
-            if (!exthtlc) {
-                return true;
-            }
+            cache.ICXCloseDFCHTLC(*dfchtlc, status);
+        }
+    };
 
-            auto offer = cache.GetICXMakeOfferByCreationTx(exthtlc->offerTx);
-            if (!offer) {
-                return true;
-            }
+    auto expireSubmitEXTHTLC = [&](const uint256 &txid, uint8_t status) {
+        auto exthtlc = cache.GetICXSubmitEXTHTLCByCreationTx(txid);
+        if (!exthtlc) {
+            return;
+        }
 
-            auto order = cache.GetICXOrderByCreationTx(offer->orderTx);
-            if (!order) {
-                return true;
-            }
+        auto offer = cache.GetICXMakeOfferByCreationTx(exthtlc->offerTx);
+        if (!offer) {
+            return;
+        }
 
-            if (status == CICXSubmitEXTHTLC::STATUS_EXPIRED && order->orderType == CICXOrder::TYPE_EXTERNAL) {
-                if (!cache.ExistedICXSubmitDFCHTLC(exthtlc->offerTx, isPreEunosPaya)) {
-                    CTokenAmount makerDeposit{DCT_ID{0}, offer->takerFee};
-                    cache.CalculateOwnerRewards(order->ownerAddress, pindex->nHeight);
-                    cache.AddBalance(order->ownerAddress, makerDeposit);
-                    cache.ICXCloseEXTHTLC(*exthtlc, status);
-                }
+        auto order = cache.GetICXOrderByCreationTx(offer->orderTx);
+        if (!order) {
+            return;
+        }
+
+        if (status == CICXSubmitEXTHTLC::STATUS_EXPIRED && order->orderType == CICXOrder::TYPE_EXTERNAL) {
+            if (!cache.ExistedICXSubmitDFCHTLC(exthtlc->offerTx, isPreEunosPaya)) {
+                CTokenAmount makerDeposit{DCT_ID{0}, offer->takerFee};
+                calculateOwnerRewards(order->ownerAddress);
+                cache.AddBalance(order->ownerAddress, makerDeposit);
+                cache.ICXCloseEXTHTLC(*exthtlc, status);
             }
+        }
+    };
 
-            return true;
-        },
-        pindex->nHeight);
+    for (const auto &[type, txid, status] : cache.GetICXExpiring(pindex->nHeight)) {
+        switch (type) {
+            case CICXOrderView::ExpiryType::Order:
+                expireOrder(txid, status);
+                break;
+            case CICXOrderView::ExpiryType::MakeOffer:
+                expireMakeOffer(txid, status);
+                break;
+            case CICXOrderView::ExpiryType::SubmitDFCHTLC:
+                expireSubmitDFCHTLC(txid, status);
+                break;
+            case CICXOrderView::ExpiryType::SubmitEXTHTLC:
+                expireSubmitEXTHTLC(txid, status);
+                break;
+        }
+    }
 }
 
 static uint32_t GetNextBurnPosition() {
@@ -528,6 +519,7 @@ static void ProcessOracleEvents(const CBlockIndex *pindex, CCustomCSView &cache,
     if (pindex->nHeight % blockInterval != 0) {
         return;
     }
+    const auto aggregatePrices = GetAggregatePrices(cache, pindex->nTime);
     cache.ForEachFixedIntervalPrice([&](const CTokenCurrencyPair &, CFixedIntervalPrice fixedIntervalPrice) {
         // Ensure that we update active and next regardless of state of things
         // And SetFixedIntervalPrice on each evaluation of this block.
@@ -550,8 +542,11 @@ static void ProcessOracleEvents(const CBlockIndex *pindex, CCustomCSView &cache,
         fixedIntervalPrice.timestamp = pindex->nTime;
         // Use -1 to indicate empty price
         fixedIntervalPrice.priceRecord[1] = -1;
-        auto aggregatePrice = GetAggregatePrice(
-            cache, fixedIntervalPrice.priceFeedId.first, fixedIntervalPrice.priceFeedId.second, pindex->nTime);
+        const auto &priceFeedId = fixedIntervalPrice.priceFeedId;
+        const auto it = aggregatePrices.find(priceFeedId);
+        auto aggregatePrice = it != aggregatePrices.end()
+                                  ? it->second
+                                  : GetAggregatePrice(cache, priceFeedId.first, priceFeedId.second, pindex->nTime);
         if (aggregatePrice) {
             fixedIntervalPrice.priceRecord[1] = aggregatePrice;
         } else {
@@ -687,182 +682,132 @@ static void ProcessLoanEvents(const CBlockIndex *pindex, CCustomCSView &cache, c
     if (pindex->nHeight % consensus.blocksCollateralizationRatioCalculation() == 0) {
         bool useNextPrice = false, requireLivePrice = true;
 
-        auto &pool = DfTxTaskPool->pool;
-
-        struct VaultWithCollateralInfo {
-            CVaultId vaultId;
-            CBalances collaterals;
-            CVaultAssets vaultAssets;
-            CVaultData vault;
-        };
-
-        struct LiquidationVaults {
-        public:
-            AtomicMutex m;
-            std::vector<VaultWithCollateralInfo> vaults;
-        };
-        LiquidationVaults lv;
-
-        TaskGroup g;
-
-        const auto markCompleted = [&g] { g.RemoveTask(); };
-
+        std::vector<std::pair<CVaultId, CBalances>> vaultCollaterals;
         cache.ForEachVaultCollateral([&](const CVaultId &vaultId, const CBalances &collaterals) {
-            g.AddTask();
-
-            CVaultId vaultIdCopy = vaultId;
-            CBalances collateralsCopy = collaterals;
-
-            boost::asio::post(
-                pool,
-                [vaultIdCopy, collateralsCopy, &cache, pindex, useNextPrice, requireLivePrice, &lv, &markCompleted] {
-                    auto vaultId = vaultIdCopy;
-                    auto collaterals = collateralsCopy;
-
-                    auto vaultAssets = cache.GetVaultAssets(
-                        vaultId, collaterals, pindex->nHeight, pindex->nTime, useNextPrice, requireLivePrice);
-
-                    if (!vaultAssets) {
-                        markCompleted();
-                        return;
-                    }
-
-                    auto vault = cache.GetVault(vaultId);
-                    assert(vault);
-
-                    auto scheme = cache.GetLoanScheme(vault->schemeId);
-                    assert(scheme);
-
-                    if (scheme->ratio <= vaultAssets.val->ratio()) {
-                        // All good, within ratio, nothing more to do.
-                        markCompleted();
-                        return;
-                    }
-
-                    {
-                        std::unique_lock lock{lv.m};
-                        lv.vaults.push_back(VaultWithCollateralInfo{vaultId, collaterals, vaultAssets, *vault});
-                    }
-                    markCompleted();
-                });
+            vaultCollaterals.emplace_back(vaultId, collaterals);
             return true;
         });
 
-        g.WaitForCompletion();
-
-        {
-            std::unique_lock lock{lv.m};
-            for (auto &[vaultId, collaterals, vaultAssets, vault] : lv.vaults) {
-                // Time to liquidate vault.
-                vault.isUnderLiquidation = true;
-                cache.StoreVault(vaultId, vault);
-                auto loanTokens = cache.GetLoanTokens(vaultId);
-                assert(loanTokens);
-
-                // Get the interest rate for each loan token in the vault, find
-                // the interest value and move it to the totals, removing it from the
-                // vault, while also stopping the vault from accumulating interest
-                // further. Note, however, it's added back so that it's accurate
-                // for auction calculations.
-                CBalances totalInterest;
-                for (auto it = loanTokens->balances.begin(); it != loanTokens->balances.end();) {
-                    const auto &[tokenId, tokenValue] = *it;
-
-                    auto rate = cache.GetInterestRate(vaultId, tokenId, pindex->nHeight);
-                    assert(rate);
-
-                    auto subInterest = TotalInterest(*rate, pindex->nHeight);
-                    if (subInterest > 0) {
-                        totalInterest.Add({tokenId, subInterest});
-                    }
+        // Vaults to liquidate, kept in collateral key order
+        auto liquidations = cache.GetVaultsBelowRatio(
+            vaultCollaterals, pindex->nHeight, pindex->nTime, useNextPrice, requireLivePrice);
 
-                    // Remove loan from the vault
-                    cache.SubLoanToken(vaultId, {tokenId, tokenValue});
+        for (size_t index = 0; index < liquidations.size(); ++index) {
+            if (!liquidations[index]) {
+                continue;
+            }
+            const auto &[vaultId, collaterals] = vaultCollaterals[index];
+            const auto &vaultAssets = *liquidations[index];
+            auto vault = *cache.GetVault(vaultId);
+            // Time to liquidate vault.
+            vault.isUnderLiquidation = true;
+            cache.StoreVault(vaultId, vault);
+            auto loanTokens = cache.GetLoanTokens(vaultId);
+            assert(loanTokens);
+
+            // Get the interest rate for each loan token in the vault, find
+            // the interest value and move it to the totals, removing it from the
+            // vault, while also stopping the vault from accumulating interest
+            // further. Note, however, it's added back so that it's accurate
+            // for auction calculations.
+            CBalances totalInterest;
+            for (auto it = loanTokens->balances.begin(); it != loanTokens->balances.end();) {
+                const auto &[tokenId, tokenValue] = *it;
+
+                auto rate = cache.GetInterestRate(vaultId, tokenId, pindex->nHeight);
+                assert(rate);
+
+                auto subInterest = TotalInterest(*rate, pindex->nHeight);
+                if (subInterest > 0) {
+                    totalInterest.Add({tokenId, subInterest});
+                }
 
-                    if (const auto token = cache.GetToken("DUSD"); token && token->first == tokenId) {
-                        TrackDUSDSub(cache, {tokenId, tokenValue});
-                    }
+                // Remove loan from the vault
+                cache.SubLoanToken(vaultId, {tokenId, tokenValue});
 
-                    // Remove interest from the vault
-                    cache.DecreaseInterest(pindex->nHeight,
-                                           vaultId,
-                                           vault.schemeId,
-                                           tokenId,
-                                           tokenValue,
-                                           subInterest < 0 || (!subInterest && rate->interestPerBlock.negative)
-                                               ? std::numeric_limits<CAmount>::max()
-                                               : subInterest);
+                if (const auto token = cache.GetToken("DUSD"); token && token->first == tokenId) {
+                    TrackDUSDSub(cache, {tokenId, tokenValue});
+                }
 
-                    // Putting this back in now for auction calculations.
-                    it->second += subInterest;
+                // Remove interest from the vault
+                cache.DecreaseInterest(pindex->nHeight,
+                                       vaultId,
+                                       vault.schemeId,
+                                       tokenId,
+                                       tokenValue,
+                                       subInterest < 0 || (!subInterest && rate->interestPerBlock.negative)
+                                           ? std::numeric_limits<CAmount>::max()
+                                           : subInterest);
 
-                    // If loan amount fully negated then remove it
-                    if (it->second < 0) {
-                        TrackNegativeInterest(cache, {tokenId, tokenValue});
+                // Putting this back in now for auction calculations.
+                it->second += subInterest;
 
-                        it = loanTokens->balances.erase(it);
-                    } else {
-                        if (subInterest < 0) {
-                            TrackNegativeInterest(cache, {tokenId, std::abs(subInterest)});
-                        }
+                // If loan amount fully negated then remove it
+                if (it->second < 0) {
+                    TrackNegativeInterest(cache, {tokenId, tokenValue});
 
-                        ++it;
+                    it = loanTokens->balances.erase(it);
+                } else {
+                    if (subInterest < 0) {
+                        TrackNegativeInterest(cache, {tokenId, std::abs(subInterest)});
                     }
-                }
 
-                // Remove the collaterals out of the vault.
-                // (Prep to get the auction batches instead)
-                for (const auto &col : collaterals.balances) {
-                    auto tokenId = col.first;
-                    auto tokenValue = col.second;
-                    cache.SubVaultCollateral(vaultId, {tokenId, tokenValue});
+                    ++it;
                 }
+            }
 
-                auto batches = CollectAuctionBatches(vaultAssets, collaterals.balances, loanTokens->balances);
-
-                // Now, let's add the remaining amounts and store the batch.
-                CBalances totalLoanInBatches{};
-                for (auto i = 0u; i < batches.size(); i++) {
-                    auto &batch = batches[i];
-                    totalLoanInBatches.Add(batch.loanAmount);
-                    auto tokenId = batch.loanAmount.nTokenId;
-                    auto interest = totalInterest.balances[tokenId];
-                    if (interest > 0) {
-                        auto balance = loanTokens->balances[tokenId];
-                        auto interestPart = DivideAmounts(batch.loanAmount.nValue, balance);
-                        batch.loanInterest = MultiplyAmounts(interestPart, interest);
-                        totalLoanInBatches.Sub({tokenId, batch.loanInterest});
-                    }
-                    cache.StoreAuctionBatch({vaultId, i}, batch);
+            // Remove the collaterals out of the vault.
+            // (Prep to get the auction batches instead)
+            for (const auto &col : collaterals.balances) {
+                auto tokenId = col.first;
+                auto tokenValue = col.second;
+                cache.SubVaultCollateral(vaultId, {tokenId, tokenValue});
+            }
+
+            auto batches = CollectAuctionBatches(vaultAssets, collaterals.balances, loanTokens->balances);
+
+            // Now, let's add the remaining amounts and store the batch.
+            CBalances totalLoanInBatches{};
+            for (auto i = 0u; i < batches.size(); i++) {
+                auto &batch = batches[i];
+                totalLoanInBatches.Add(batch.loanAmount);
+                auto tokenId = batch.loanAmount.nTokenId;
+                auto interest = totalInterest.balances[tokenId];
+                if (interest > 0) {
+                    auto balance = loanTokens->balances[tokenId];
+                    auto interestPart = DivideAmounts(batch.loanAmount.nValue, balance);
+                    batch.loanInterest = MultiplyAmounts(interestPart, interest);
+                    totalLoanInBatches.Sub({tokenId, batch.loanInterest});
                 }
+                cache.StoreAuctionBatch({vaultId, i}, batch);
+            }
 
-                // Check if more than loan amount was generated.
-                CBalances balances;
-                for (const auto &[tokenId, amount] : loanTokens->balances) {
-                    if (totalLoanInBatches.balances.count(tokenId)) {
-                        const auto interest =
-                            totalInterest.balances.count(tokenId) ? totalInterest.balances[tokenId] : 0;
-                        if (totalLoanInBatches.balances[tokenId] > amount - interest) {
-                            balances.Add({tokenId, totalLoanInBatches.balances[tokenId] - (amount - interest)});
-                        }
+            // Check if more than loan amount was generated.
+            CBalances balances;
+            for (const auto &[tokenId, amount] : loanTokens->balances) {
+                if (totalLoanInBatches.balances.count(tokenId)) {
+                    const auto interest =
+                        totalInterest.balances.count(tokenId) ? totalInterest.balances[tokenId] : 0;
+                    if (totalLoanInBatches.balances[tokenId] > amount - interest) {
+                        balances.Add({tokenId, totalLoanInBatches.balances[tokenId] - (amount - interest)});
                     }
                 }
+            }
 
-                // Only store to attributes if there has been a rounding error.
-                if (!balances.balances.empty()) {
-                    TrackLiveBalances(cache, balances, EconomyKeys::BatchRoundingExcess);
-                }
+            // Only store to attributes if there has been a rounding error.
+            if (!balances.balances.empty()) {
+                TrackLiveBalances(cache, balances, EconomyKeys::BatchRoundingExcess);
+            }
 
-                // All done. Ready to save the overall auction.
-                cache.StoreAuction(vaultId,
-                                   CAuctionData{uint32_t(batches.size()),
-                                                pindex->nHeight + consensus.blocksCollateralAuction(),
-                                                cache.GetLoanLiquidationPenalty()});
+            // All done. Ready to save the overall auction.
+            cache.StoreAuction(vaultId,
+                               CAuctionData{uint32_t(batches.size()),
+                                            pindex->nHeight + consensus.blocksCollateralAuction(),
+                                            cache.GetLoanLiquidationPenalty()});
 
-                // Store state in vault DB
-                if (pvaultHistoryDB) {
-                    pvaultHistoryDB->WriteVaultState(cache, *pindex, vaultId, vaultAssets.ratio());
-                }
+            // Store state in vault DB
+            if (pvaultHistoryDB) {
+                pvaultHistoryDB->WriteVaultState(cache, *pindex, vaultId, vaultAssets.ratio());
             }
         }
     }
@@ -1179,7 +1124,7 @@ static void ProcessFutures(const CBlockIndex *pindex, CCustomCSView &cache, cons
         return;
     }
 
-    auto attributes = cache.GetAttributes();
+    auto attributes = cache.CopyAttributes();
 
     CDataStructureV0 activeKey{AttributeTypes::Param, ParamIDs::DFIP2203, DFIPKeys::Active};
     CDataStructureV0 blockKey{AttributeTypes::Param, ParamIDs::DFIP2203, DFIPKeys::BlockPeriod};
@@ -1375,7 +1320,7 @@ static void ProcessGovEvents(const CBlockIndex *pindex,
             CCustomCSView govCache(cache);
             // Add to existing ATTRIBUTES instead of overwriting.
             if (var->GetName() == "ATTRIBUTES") {
-                auto govVar = cache.GetAttributes();
+                auto govVar = cache.CopyAttributes();
                 govVar->time = pindex->GetBlockTime();
                 govVar->evmTemplate = evmTemplate;
                 auto newVar = std::dynamic_pointer_cast<ATTRIBUTES>(var);
@@ -1566,32 +1511,34 @@ void ConsolidateRewards(CCustomCSView &view,
                         int numWorkers) {
     int nWorkers = numWorkers < 1 ? RewardConsolidationWorkersCount() : numWorkers;
     auto rewardsTime = GetTimeMicros();
-    boost::asio::thread_pool workerPool(nWorkers);
-    boost::asio::thread_pool mergeWorker(1);
+    std::vector<const CScript *> accounts;
+    accounts.reserve(owners.size());
+    for (auto &owner : owners) {
+        accounts.push_back(&owner);
+    }
+    AtomicMutex mergeMutex;
     std::atomic<uint64_t> tasksCompleted{0};
     std::atomic<uint64_t> reportedTs{0};
 
-    for (auto &owner : owners) {
-        // See https://github.com/DeFiCh/ain/pull/1291
-        // https://github.com/DeFiCh/ain/pull/1291#issuecomment-1137638060
-        // Technically not fully synchronized, but avoid races
-        // due to the segregated areas of operation.
-        boost::asio::post(workerPool, [&, &account = owner]() {
-            if (interruptOnShutdown && ShutdownRequested()) {
-                return;
-            }
-            auto tempView = std::make_unique<CCustomCSView>(view);
-            tempView->CalculateOwnerRewards(account, height);
-
-            boost::asio::post(mergeWorker, [&, tempView = std::move(tempView)]() {
+    // See https://github.com/DeFiCh/ain/pull/1291
+    // https://github.com/DeFiCh/ain/pull/1291#issuecomment-1137638060
+    // Technically not fully synchronized, but avoid races
+    // due to the segregated areas of operation.
+    ParallelFor(
+        accounts.size(),
+        16,
+        [&](const size_t begin, const size_t end) {
+            for (auto i = begin; i < end; ++i) {
                 if (interruptOnShutdown && ShutdownRequested()) {
                     return;
                 }
-                tempView->Flush();
+                CCustomCSView tempView(view);
+                tempView.CalculateOwnerRewards(*accounts[i], height);
+
+                // Merges are serialized, relaxed ordering is more than sufficient.
+                std::unique_lock lock{mergeMutex};
+                tempView.Flush();
 
-                // This entire block is already serialized with single merge worker.
-                // So, relaxed ordering is more than sufficient - don't even need
-                // atomics really.
                 auto itemsCompleted = tasksCompleted.fetch_add(1, std::memory_order::memory_order_relaxed);
                 const auto logTimeIntervalMillis = 3 * 1000;
                 if (GetTimeMillis() - reportedTs > logTimeIntervalMillis) {
@@ -1601,11 +1548,9 @@ void ConsolidateRewards(CCustomCSView &view,
                               owners.size());
                     reportedTs.store(GetTimeMillis(), std::memory_order::memory_order_relaxed);
                 }
-            });
-        });
-    }
-    workerPool.join();
-    mergeWorker.join();
+            }
+        },
+        nWorkers);
 
     auto itemsCompleted = tasksCompleted.load();
     LogPrintf("Reward consolidation: 100%% completed (%d/%d, time: %dms)\n",
@@ -2666,7 +2611,7 @@ static Res PaybackLoanWithTokenOrDUSDCollateral(
 
     const auto height = blockCtx.GetHeight();
     const auto &consensus = blockCtx.GetConsensus();
-    auto attributes = mnview.GetAttributes();
+    auto attributes = mnview.CopyAttributes();
 
     if (!IsVaultPriceValid(mnview, vaultId, height)) {
         return DeFiErrors::LoanAssetPriceInvalid();
@@ -3611,7 +3556,7 @@ static Res ConvertAllLoanTokenForTokenLock(const CBlock &block,
         }
     }
 
-    auto attributes = cache.GetAttributes();
+    auto attributes = cache.CopyAttributes();
     // get tokens with matched with creationTx
     // get list of pools, matched with creationTx
 
@@ -3943,7 +3888,7 @@ static Res LockTokensOfBalancesCollAndPools(const CBlock &block,
     addView.Flush();
 
     CDataStructureV0 releaseKey{AttributeTypes::Live, ParamIDs::Economy, EconomyKeys::TokenLockRatio};
-    auto attributes = cache.GetAttributes();
+    auto attributes = cache.CopyAttributes();
     attributes->SetValue(releaseKey, lockRatio);
     cache.SetVariable(*attributes);
     cache.Flush();
@@ -3961,7 +3906,7 @@ static void ProcessTokenLock(const CBlock &block,
         return;
     }
 
-    const auto attributes = cache.GetAttributes();
+    const auto attributes = cache.CopyAttributes();
     CDataStructureV0 lockedTokenKey{AttributeTypes::Live, ParamIDs::Economy, EconomyKeys::LockedTokens};
     const auto lockedTokens = attributes->GetValue(lockedTokenKey, CBalances{});
     if (!lockedTokens.balances.empty()) {
@@ -4026,7 +3971,7 @@ static void ProcessTokenSplits(const CBlockIndex *pindex,
     if (pindex->nHeight < consensus.DF16FortCanningCrunchHeight) {
         return;
     }
-    const auto attributes = cache.GetAttributes();
+    const auto attributes = cache.CopyAttributes();
 
     CDataStructureV0 splitKey{AttributeTypes::Oracles, OracleIDs::Splits, static_cast<uint32_t>(pindex->nHeight)};
     bool splitSuccess = true;
@@ -4047,7 +3992,7 @@ static void ProcessFuturesDUSD(const CBlockIndex *pindex, CCustomCSView &cache,
         return;
     }
 
-    auto attributes = cache.GetAttributes();
+    auto attributes = cache.CopyAttributes();
 
     CDataStructureV0 activeKey{AttributeTypes::Param, ParamIDs::DFIP2206F, DFIPKeys::Active};
     CDataStructureV0 blockKey{AttributeTypes::Param, ParamIDs::DFIP2206F, DFIPKeys::BlockPeriod};
@@ -4197,7 +4142,7 @@ static void ProcessNegativeInterest(const CBlockIndex *pindex, CCustomCSView &ca
         return;
     }
 
-    auto attributes = cache.GetAttributes();
+    auto attributes = cache.CopyAttributes();
 
     DCT_ID dusd{};
     const auto token = cache.GetTokenGuessId("DUSD", dusd);
@@ -4266,12 +4211,14 @@ static void ProcessProposalEvents(const CBlockIndex *pindex, CCustomCSView &cach
             }
 
             if (activeMasternodes.empty()) {
-                cache.ForEachMasternode([&](const uint256 &mnId, CMasternode node) {
-                    if (node.IsActive(pindex->nHeight, cache) && node.mintedBlocks) {
-                        activeMasternodes.insert(mnId);
-                    }
-                    return true;
-                });
+                cache.ForEachActiveCandidate(
+                    [&](const uint256 &mnId, CMasternode node) {
+                        if (node.IsActive(pindex->nHeight, cache) && node.mintedBlocks) {
+                            activeMasternodes.insert(mnId);
+                        }
+                        return true;
+                    },
+                    pindex->nHeight);
                 if (activeMasternodes.empty()) {
                     return false;
                 }
@@ -4433,7 +4380,7 @@ static void ProcessGrandCentralEvents(const CBlockIndex *pindex,
         return;
     }
 
-    auto attributes = cache.GetAttributes();
+    auto attributes = cache.CopyAttributes();
 
     CDataStructureV0 key{AttributeTypes::Param, ParamIDs::Foundation, DFIPKeys::Members};
     attributes->SetValue(key, consensus.foundationMembers);
@@ -4557,7 +4504,7 @@ static Res ProcessEVMQueue(const CBlock &block,
         return res;
     }
 
-    auto attributes = cache.GetAttributes();
+    auto attributes = cache.CopyAttributes();
 
     auto stats = attributes->GetValue(CEvmBlockStatsLive::Key, CEvmBlockStatsLive{});
 
@@ -4610,27 +4557,29 @@ static void FlushCacheCreateUndo(const CBlockIndex *pindex,
                                  const uint256 hash) {
     // construct undo
     auto &flushable = cache.GetStorage();
-    auto undo = CUndo::Construct(mnview.GetStorage(), flushable.GetRaw());
+    const auto hasChanges = !flushable.GetRaw().empty();
+    const auto undo = hasChanges ? CUndo::ConstructRaw(mnview.GetStorage(), flushable.GetRaw()) : TBytes{};
     // flush changes to underlying view
     cache.Flush();
     // write undo
-    if (!undo.before.empty()) {
-        mnview.SetUndo(UndoKey{static_cast<uint32_t>(pindex->nHeight), hash}, undo);
+    if (hasChanges) {
+        mnview.SetUndoRaw(UndoKey{static_cast<uint32_t>(pindex->nHeight), hash}, undo);
     }
 }
 
-static CrossBoundaryResult OceanIndex(const UniValue b, const uint32_t height) {
+// The block is serialized once and the same string is handed over on the retries
+static CrossBoundaryResult OceanIndex(const std::string &block, const uint32_t height) {
     auto time = GetTimeMillis();
     CrossBoundaryResult result;
-    ocean_index_block(result, b.write());
+    ocean_index_block(result, block);
     if (!result.ok) {
         LogPrintf("Error indexing block %d : %s\n", height, result.reason);
-        ocean_invalidate_block(result, b.write());
+        ocean_invalidate_block(result, block);
         if (!result.ok) {
             LogPrintf("Error invalidating block %d: %s\n", height, result.reason);
             return result;
         }
-        OceanIndex(b, height);
+        OceanIndex(block, height);
     }
     LogPrint(BCLog::OCEAN, "Indexing ocean block %d took: %dms\n", height, GetTimeMillis() - time);
     return result;
@@ -4644,13 +4593,16 @@ Res ProcessDeFiEventFallible(const CBlock &block,
     auto isEvmEnabledForBlock = blockCtx.GetEVMEnabledForBlock();
     auto &mnview = blockCtx.GetView();
     CCustomCSView cache(mnview);
+    CProcessStageTimer stageTimer;
 
     // One time upgrade to lock away 90% of dToken supply.
     // Needs to execute before ProcessEVMQueue to avoid block hash mismatch.
     ProcessTokenLock(block, pindex, cache, blockCtx);
+    stageTimer.Lap("tokenlock");
 
     // Loan splits
     ProcessTokenSplits(pindex, cache, creationTxs, blockCtx);
+    stageTimer.Lap("tokensplits");
 
     if (isEvmEnabledForBlock) {
         // Process EVM block
@@ -4659,18 +4611,21 @@ Res ProcessDeFiEventFallible(const CBlock &block,
             return res;
         }
     }
+    stageTimer.Lap("evmqueue");
 
     // Construct undo
     FlushCacheCreateUndo(pindex, mnview, cache, uint256S(std::string(64, '1')));
+    stageTimer.Lap("undo");
 
     // Ocean archive
     if (gArgs.GetBoolArg("-oceanarchive", DEFAULT_OCEAN_INDEXER_ENABLED)) {
-        const UniValue b = blockToJSON(cache, block, ::ChainActive().Tip(), pindex, true, 2);
+        const auto b = blockToJSON(cache, block, ::ChainActive().Tip(), pindex, true, 2).write();
 
         if (CrossBoundaryResult result = OceanIndex(b, static_cast<uint32_t>(pindex->nHeight)); !result.ok) {
             return Res::Err(result.reason.c_str());
         }
     }
+    stageTimer.Lap("ocean");
 
     return Res::Ok();
 }
@@ -4684,61 +4639,79 @@ void ProcessDeFiEvent(const CBlock &block,
     auto &evmTemplate = blockCtx.GetEVMTemplate();
     auto &mnview = blockCtx.GetView();
     CCustomCSView cache(mnview);
+    CProcessStageTimer stageTimer;
 
     // calculate rewards to current block
     ProcessRewardEvents(pindex, cache, consensus);
+    stageTimer.Lap("rewards");
 
     // close expired orders, refund all expired DFC HTLCs at this block height
     ProcessICXEvents(pindex, cache, consensus);
+    stageTimer.Lap("icx");
 
     // Remove `Finalized` and/or `LPS` flags _possibly_set_ by bytecoded (cheated) txs before bayfront fork
     if (pindex->nHeight == consensus.DF2BayfrontHeight - 1) {  // call at block _before_ fork
         cache.BayfrontFlagsCleanup();
     }
+    stageTimer.Lap("bayfrontcleanup");
 
     // burn DFI on Eunos height
     ProcessEunosEvents(pindex, cache, consensus);
+    stageTimer.Lap("eunos");
 
     // set oracle prices
     ProcessOracleEvents(pindex, cache, consensus);
+    stageTimer.Lap("oracles");
 
     // loan scheme, collateral ratio, liquidations
     ProcessLoanEvents(pindex, cache, consensus);
+    stageTimer.Lap("loans");
 
     // Must be before set gov by height to clear futures in case there's a disabling of loan token in v3+
     ProcessFutures(pindex, cache, consensus);
+    stageTimer.Lap("futures");
 
     // update governance variables
     ProcessGovEvents(pindex, cache, consensus, evmTemplate);
+    stageTimer.Lap("gov");
 
     // Migrate loan and collateral tokens to Gov vars.
     ProcessTokenToGovVar(pindex, cache, consensus);
+    stageTimer.Lap("tokentogovvar");
 
     // Set height for live dex data
     if (cache.GetDexStatsEnabled().value_or(false)) {
         cache.SetDexStatsLastHeight(pindex->nHeight);
     }
+    stageTimer.Lap("dexstats");
 
     // DFI-to-DUSD swaps
     ProcessFuturesDUSD(pindex, cache, consensus);
+    stageTimer.Lap("futuresdusd");
 
     // Tally negative interest across vaults
     ProcessNegativeInterest(pindex, cache);
+    stageTimer.Lap("negativeinterest");
 
     // proposal activations
     ProcessProposalEvents(pindex, cache, consensus);
+    stageTimer.Lap("proposals");
 
     // Masternode updates
     ProcessMasternodeUpdates(pindex, cache, view, consensus);
+    stageTimer.Lap("masternodes");
 
     // Migrate foundation members to attributes
     ProcessGrandCentralEvents(pindex, cache, consensus);
+    stageTimer.Lap("grandcentral");
 
     // Refund null pool swap amounts
     ProcessNullPoolSwapRefund(pindex, cache, consensus);
+    stageTimer.Lap("nullpoolswaprefund");
 
     // construct undo
     FlushCacheCreateUndo(pindex, mnview, cache, uint256());
+    stageTimer.Lap("undo");
 }
 
 bool ExecuteTokenMigrationEVM(std::size_t mnview_ptr, const TokenAmount oldAmount, TokenAmount &newAmount) {
@@ -4760,7 +4733,7 @@ bool ExecuteTokenMigrationEVM(std::size_t mnview_ptr, const TokenAmount oldAmoun
 
     CDataStructureV0 lockedKey{AttributeTypes::Live, ParamIDs::Economy, EconomyKeys::LockedTokens};
     CDataStructureV0 releaseKey{AttributeTypes::Live, ParamIDs::Economy, EconomyKeys::TokenLockRatio};
-    auto attributes = cache->GetAttributes();
+    auto attributes = cache->CopyAttributes();
     const auto lockRatio = attributes->GetValue(releaseKey, CAmount{});
     const auto lockedTokens = attributes->GetValue(lockedKey, CBalances{});
     if (lockRatio > 0 && lockedTokens.balances.count(DCT_ID{oldAmount.id}) > 0) {
@@ -11,15 +11,20 @@
 
 #include <dbwrapper.h>
 #include <functional>
+#include <kvmap.h>
+#include <list>
 #include <map>
 #include <memusage.h>
 
+#include <atomic>
 #include <optional>
+#include <sync.h>
+#include <typeindex>
 
 extern CCriticalSection cs_main;
 
-using TBytes = std::vector<unsigned char>;
-using MapKV = std::map<TBytes, std::optional<TBytes>>;
+// Borrowed key or value bytes
+using TBytesView = Span<const unsigned char>;
 
 template<typename T>
 static TBytes DbTypeToBytes(const T& value) {
@@ -42,6 +47,18 @@ static bool BytesToDbType(const TBytes& bytes, T& value) {
     return true;
 }
 
+template<typename T>
+static bool BytesToDbType(TBytesView bytes, T& value) {
+    try {
+        SpanReader stream(SER_DISK, CLIENT_VERSION, bytes);
+        stream >> value;
+    }
+    catch (std::ios_base::failure&) {
+        return false;
+    }
+    return true;
+}
+
 // Key-Value storage iterator interface
 class CStorageKVIterator {
 public:
@@ -50,8 +67,19 @@ public:
     virtual void Next() = 0;
     virtual void Prev() = 0;
     virtual bool Valid() = 0;
-    virtual TBytes Key() = 0;
-    virtual TBytes Value() = 0;
+    // Views are borrowed from the underlying storage and
+    // only valid until the iterator is moved
+    virtual TBytesView KeyView() = 0;
+    virtual TBytesView ValueView() = 0;
+
+    TBytes Key() {
+        const auto key = KeyView();
+        return {key.begin(), key.end()};
+    }
+    TBytes Value() {
+        const auto value = ValueView();
+        return {value.begin(), value.end()};
+    }
 };
 
 // Represents an empty iterator
@@ -62,8 +90,8 @@ public:
     void Next() override {}
     void Prev() override {}
     bool Valid() override { return false; }
-    TBytes Key() override { return {}; }
-    TBytes Value() override { return {}; }
+    TBytesView KeyView() override { return {}; }
+    TBytesView ValueView() override { return {}; }
 };
 
 // Key-Value storage interface
@@ -77,6 +105,11 @@ public:
     virtual std::unique_ptr<CStorageKVIterator> NewIterator() = 0;
     virtual size_t SizeEstimate() const = 0;
     virtual bool Flush() = 0;
+    // Hints that the keys are about to be read, storages backed by a
+    // database can resolve them ahead of time
+    virtual void Prefetch(const std::vector<TBytes>& keys) {}
+    // Decoded object cached for the key, see CStorageView::ReadCached
+    virtual std::shared_ptr<const void> GetDecoded(const TBytes& key, std::type_index type, bool prefix) const { return {}; }
 };
 
 // doesn't serialize/deserialize vector size
@@ -111,7 +144,7 @@ public:
     ~CStorageLevelDBIterator() override = default;
 
     void Seek(const TBytes& key) override {
-        it->Seek(refTBytes(key)); // lower_bound in fact
+        it->SeekRaw(MakeSpan(key)); // lower_bound in fact
     }
     void Next() override {
         it->Next();
@@ -122,20 +155,26 @@ public:
     bool Valid() override {
         return it->Valid();
     }
-    TBytes Key() override {
-        TBytes key;
-        auto rawKey = refTBytes(key);
-        return it->GetKey(rawKey) ? key : TBytes{};
+    TBytesView KeyView() override {
+        return it->GetKeyRaw();
     }
-    TBytes Value() override {
-        TBytes value;
-        auto rawValue = refTBytes(value);
-        return it->GetValue(rawValue) ? value : TBytes{};
+    TBytesView ValueView() override {
+        return it->GetValueRaw(buffer);
     }
 private:
     std::unique_ptr<CDBIterator> it;
+    // holds de-obfuscated values
+    TBytes buffer;
+};
+
+// Reads that reach the LevelDB storage, and the ones its prefetch cache answers
+struct CStorageReadStats {
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> prefetchHits{0};
 };
 
+extern CStorageReadStats storageReadStats;
+
 // LevelDB glue layer storage
 class CStorageLevelDB : public CStorageKV {
 public:
@@ -168,11 +207,21 @@ public:
         return true;
     }
     bool Read(const TBytes& key, TBytes& value) const override {
-        auto rawVal = refTBytes(value);
-        if (snapshot) {
-            return db->Read(refTBytes(key), rawVal, options);
+        storageReadStats.reads.fetch_add(1, std::memory_order_relaxed);
+        if (prefetchedCount.load(std::memory_order_acquire)) {
+            LOCK(cs_prefetch);
+            if (auto it = prefetched.find(key); it != prefetched.end()) {
+                const auto found = it->second.has_value();
+                if (found) {
+                    value = std::move(*it->second);
+                }
+                prefetched.erase(it);
+                prefetchedCount.store(prefetched.size(), std::memory_order_release);
+                storageReadStats.prefetchHits.fetch_add(1, std::memory_order_relaxed);
+                return found;
+            }
         }
-        return db->Read(refTBytes(key), rawVal);
+        return ReadDB(key, value);
     }
     bool Flush() override { // Commit batch
         // Since all other writes are blocked, flushing
@@ -180,8 +229,46 @@ public:
         if (snapshot) return true;
         auto result = db->WriteBatch(batch);
         batch.Clear();
+        {
+            // Prefetched values predate the batch
+            LOCK(cs_prefetch);
+            ++prefetchGeneration;
+            prefetched.clear();
+            prefetchedCount.store(0, std::memory_order_release);
+        }
         return result;
     }
+    // Reads the keys into a read cache, Read takes them out of it. Safe to
+    // call from several threads, results that race with a Flush are dropped.
+    void Prefetch(const std::vector<TBytes>& keys) override {
+        uint64_t generation;
+        {
+            LOCK(cs_prefetch);
+            generation = prefetchGeneration;
+        }
+        std::vector<std::pair<TBytes, std::optional<TBytes>>> values;
+        values.reserve(keys.size());
+        for (const auto& key : keys) {
+            TBytes value;
+            if (ReadDB(key, value)) {
+                values.emplace_back(key, std::move(value));
+            } else {
+                values.emplace_back(key, std::nullopt);
+            }
+        }
+        LOCK(cs_prefetch);
+        if (generation != prefetchGeneration) {
+            return;
+        }
+        // Entries that were never read are stale hints, drop them when full
+        if (prefetched.size() + values.size() > PREFETCH_MAX_ENTRIES) {
+            prefetched.clear();
+        }
+        for (auto& [key, value] : values) {
+            prefetched.insert_or_assign(std::move(key), std::move(value));
+        }
+        prefetchedCount.store(prefetched.size(), std::memory_order_release);
+    }
     size_t SizeEstimate() const override {
         if (snapshot) return 0;
         return batch.SizeEstimate();
@@ -212,10 +299,24 @@ public:
     }
 
 private:
+    bool ReadDB(const TBytes& key, TBytes& value) const {
+        if (snapshot) {
+            return db->ReadRaw(MakeSpan(key), value, options);
+        }
+        return db->ReadRaw(MakeSpan(key), value);
+    }
+
+    static constexpr size_t PREFETCH_MAX_ENTRIES = 1 << 16;
+
     std::shared_ptr<CDBWrapper> db;
     CDBBatch batch;
     leveldb::ReadOptions options;
 
+    mutable Mutex cs_prefetch;
+    mutable MapKV prefetched GUARDED_BY(cs_prefetch);
+    mutable std::atomic<size_t> prefetchedCount{0};
+    uint64_t prefetchGeneration GUARDED_BY(cs_prefetch){0};
+
     // If this snapshot is set it will be used when
     // reading from the DB.
     std::unique_ptr<CCheckedOutSnapshot> snapshot;
@@ -226,7 +327,7 @@ private:
 // Flushable Key-Value Storage Iterator
 class CFlushableStorageKVIterator : public CStorageKVIterator {
 public:
-    explicit CFlushableStorageKVIterator(std::unique_ptr<CStorageKVIterator>&& pIt, MapKV& map) : map(map), pIt(std::move(pIt)) {
+    explicit CFlushableStorageKVIterator(std::unique_ptr<CStorageKVIterator>&& pIt, const ArenaMapKV& map) : map(map), pIt(std::move(pIt)) {
         itState = Invalid;
     }
     CFlushableStorageKVIterator(const CFlushableStorageKVIterator&) = delete;
@@ -234,20 +335,23 @@ public:
 
     void Seek(const TBytes& key) override {
         pIt->Seek(key);
-        mIt = Advance(map.lower_bound(key), map.end(), std::greater<TBytes>{}, {});
+        prevKey.clear();
+        mIt = Advance(map.lower_bound(key), map.end(), KeyBytesGreater{});
     }
     void Next() override {
         assert(Valid());
-        mIt = Advance(mIt, map.end(), std::greater<TBytes>{}, Key());
+        SetPrevKey(KeyView());
+        mIt = Advance(mIt, map.end(), KeyBytesGreater{});
     }
     void Prev() override {
         assert(Valid());
+        SetPrevKey(KeyView());
         auto tmp = mIt;
         if (tmp != map.end()) {
             ++tmp;
         }
         auto it = std::reverse_iterator<decltype(tmp)>(tmp);
-        auto end = Advance(it, map.rend(), std::less<TBytes>{}, Key());
+        auto end = Advance(it, map.rend(), KeyBytesLess{});
         if (end == map.rend()) {
             mIt = map.begin();
         } else {
@@ -258,32 +362,36 @@ public:
     bool Valid() override {
         return itState != Invalid;
     }
-    TBytes Key() override {
+    TBytesView KeyView() override {
         assert(Valid());
-        return itState == Map ? mIt->first : pIt->Key();
+        return itState == Map ? MakeSpan(mIt->first) : pIt->KeyView();
     }
-    TBytes Value() override {
+    TBytesView ValueView() override {
         assert(Valid());
-        return itState == Map ? *mIt->second : pIt->Value();
+        return itState == Map ? MakeSpan(*mIt->second) : pIt->ValueView();
     }
 private:
+    void SetPrevKey(TBytesView key) {
+        // the view may point into the parent, which moves during Advance
+        prevKey.assign(key.begin(), key.end());
+    }
     template<typename TIterator, typename Compare>
-    TIterator Advance(TIterator it, TIterator end, Compare comp, TBytes prevKey) {
+    TIterator Advance(TIterator it, TIterator end, Compare comp) {
 
         while (it != end || pIt->Valid()) {
-            while (it != end && (!pIt->Valid() || !comp(it->first, pIt->Key()))) {
+            while (it != end && (!pIt->Valid() || !comp(it->first, pIt->KeyView()))) {
                 if (prevKey.empty() || comp(it->first, prevKey)) {
                     if (it->second) {
                         itState = Map;
                         return it;
                     } else {
-                        prevKey = it->first;
+                        prevKey.assign(it->first.begin(), it->first.end());
                     }
                 }
                 ++it;
             }
             if (pIt->Valid()) {
-                if (prevKey.empty() || comp(pIt->Key(), prevKey)) {
+                if (prevKey.empty() || comp(pIt->KeyView(), prevKey)) {
                     itState = Parent;
                     return it;
                 }
@@ -293,51 +401,69 @@ private:
         itState = Invalid;
         return it;
     }
-    void NextParent(MapKV::const_iterator&) {
+    void NextParent(ArenaMapKV::const_iterator&) {
         pIt->Next();
     }
-    void NextParent(std::reverse_iterator<MapKV::const_iterator>&) {
+    void NextParent(std::reverse_iterator<ArenaMapKV::const_iterator>&) {
         pIt->Prev();
     }
-    const MapKV& map;
-    MapKV::const_iterator mIt;
+    const ArenaMapKV& map;
+    ArenaMapKV::const_iterator mIt;
     std::unique_ptr<CStorageKVIterator> pIt;
+    // last visited key, reused across moves
+    TBytes prevKey;
     enum IteratorState { Invalid, Map, Parent } itState;
 };
 
+// Hit rate of the decoded object cache, see CStorageView::ReadCached
+struct CDecodedCacheStats {
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+};
+
+extern CDecodedCacheStats decodedCacheStats;
+
 // Flushable Key-Value Storage
 class CFlushableStorageKV : public CStorageKV {
+    // Decoded object of a key, valid while the stamp matches the layers below
+    struct DecodedEntry {
+        std::type_index type;
+        std::shared_ptr<const void> object;
+        uint64_t stamp;
+    };
+
 public:
     // Normal constructor
-    explicit CFlushableStorageKV(CStorageKV& db_) : db(db_) {}
+    explicit CFlushableStorageKV(CStorageKV& db_) : db(db_), parent(dynamic_cast<CFlushableStorageKV*>(&db_)) {}
 
-    // Snapshot constructor
-    explicit CFlushableStorageKV(std::unique_ptr<CStorageLevelDB> &db_, MapKV changed) : snapshotDB(std::move(db_)), db(*snapshotDB), changed(std::move(changed)), snapshot(true) {}
+    // Snapshot constructor, the changes of the snapshot are shared and read only,
+    // writes go to a layer of its own
+    explicit CFlushableStorageKV(std::unique_ptr<CStorageLevelDB> &db_, std::shared_ptr<const ArenaMapKV> snapshotChanged)
+        : snapshotDB(std::move(db_)), db(*snapshotDB), snapshotChanged(std::move(snapshotChanged)), snapshot(true) {}
 
     CFlushableStorageKV(const CFlushableStorageKV&) = delete;
     ~CFlushableStorageKV() override = default;
 
     bool Exists(const TBytes& key) const override {
-        auto it = changed.find(key);
-        if (it != changed.end()) {
-            return bool(it->second);
+        if (const auto value = FindChanged(key)) {
+            return bool(*value);
         }
         return db.Exists(key);
     }
     bool Write(const TBytes& key, const TBytes& value) override {
-        changed[key] = value;
+        Assign(key, value);
         return true;
     }
     bool Erase(const TBytes& key) override {
-        changed[key] = {};
+        Assign(key, std::nullopt);
         return true;
     }
     bool Read(const TBytes& key, TBytes& value) const override {
-        auto it = changed.find(key);
-        if (it == changed.end()) {
+        const auto changedValue = FindChanged(key);
+        if (!changedValue) {
             return db.Read(key, value);
-        } else if (it->second) {
-            value = it->second.value();
+        } else if (*changedValue) {
+            value = changedValue->value();
             return true;
         } else {
             return false;
@@ -347,26 +473,50 @@ public:
         if (snapshot) {
             throw std::runtime_error("Cannot Flush on storage based off a snapshot");
         }
+        const auto stamp = ParentGeneration();
+        TBytes key;
         for (const auto& it : changed) {
+            key.assign(it.first.begin(), it.first.end());
             if (!it.second) {
-                if (!db.Erase(it.first)) {
+                if (!db.Erase(key)) {
                     return false;
                 }
-            } else if (!db.Write(it.first, it.second.value())) {
+            } else if (!db.Write(key, it.second.value())) {
                 return false;
             }
         }
-        changed.clear();
+        // release the arena together with the nodes
+        changed = ArenaMapKV{};
+        if (parent) {
+            // objects decoded here are what the parent holds now
+            std::unique_lock lock{decodedMutex};
+            for (auto& [key, entry] : decoded) {
+                if (entry.stamp == stamp) {
+                    parent->SetDecoded(key, entry.type, std::move(entry.object));
+                }
+            }
+            for (auto& [key, entry] : decodedPrefixes) {
+                if (entry.stamp == stamp) {
+                    parent->SetDecoded(key, entry.type, std::move(entry.object), true);
+                }
+            }
+            decoded.clear();
+            decodedPrefixes.clear();
+        }
         return true;
     }
     size_t SizeEstimate() const override {
         return memusage::DynamicUsage(changed);
     }
     std::unique_ptr<CStorageKVIterator> NewIterator() override {
+        if (snapshotChanged) {
+            return std::make_unique<CFlushableStorageKVIterator>(
+                std::make_unique<CFlushableStorageKVIterator>(db.NewIterator(), *snapshotChanged), changed);
+        }
         return std::make_unique<CFlushableStorageKVIterator>(db.NewIterator(), changed);
     }
 
-    MapKV& GetRaw() {
+    ArenaMapKV& GetRaw() {
         return changed;
     }
 
@@ -376,19 +526,294 @@ public:
         return storageLevelDB;
     }
 
-    std::pair<MapKV, const leveldb::Snapshot*> CreateSnapshotData() {
-        return {changed, GetStorageLevelDB()->CreateLevelDBSnapshot()};
+    // Copies the changes once, snapshots taken from the data share them
+    std::pair<std::shared_ptr<const ArenaMapKV>, const leveldb::Snapshot*> CreateSnapshotData() {
+        if (snapshot) {
+            throw std::runtime_error("Cannot create snapshot data from storage based off a snapshot");
+        }
+        return {std::make_shared<const ArenaMapKV>(changed), GetStorageLevelDB()->CreateLevelDBSnapshot()};
+    }
+
+    // Looks up a decoded object in this layer, or in the storage below
+    // as long as the key is not changed here. Prefix objects are built
+    // from all keys starting with the prefix.
+    std::shared_ptr<const void> GetDecoded(const TBytes& key, std::type_index type, bool prefix = false) const override {
+        {
+            std::unique_lock lock{decodedMutex};
+            const auto& entries = prefix ? decodedPrefixes : decoded;
+            auto it = entries.find(key);
+            if (it != entries.end() && it->second.type == type && it->second.stamp == ParentGeneration()) {
+                return it->second.object;
+            }
+        }
+        if (snapshot) {
+            return {};
+        }
+        if (prefix) {
+            auto it = changed.lower_bound(key);
+            if (it != changed.end() && StartsWith(it->first, key)) {
+                return {};
+            }
+        } else if (changed.find(key) != changed.end()) {
+            return {};
+        }
+        return db.GetDecoded(key, type, prefix);
+    }
+
+    template<typename K>
+    void SetDecoded(const K& key, std::type_index type, std::shared_ptr<const void> object, bool prefix = false) const {
+        std::unique_lock lock{decodedMutex};
+        auto& entries = prefix ? decodedPrefixes : decoded;
+        auto it = entries.lower_bound(key);
+        DecodedEntry entry{type, std::move(object), ParentGeneration()};
+        if (it != entries.end() && CompareKeyBytes(key, it->first) == 0) {
+            it->second = std::move(entry);
+        } else {
+            entries.emplace_hint(it, TKeyBytes(key.begin(), key.end()), std::move(entry));
+        }
     }
 
 private:
+    // Value of a key changed here or in the snapshot changes, null when unchanged
+    const std::optional<TBytes>* FindChanged(const TBytes& key) const {
+        if (auto it = changed.find(key); it != changed.end()) {
+            return &it->second;
+        }
+        if (snapshotChanged) {
+            if (auto it = snapshotChanged->find(key); it != snapshotChanged->end()) {
+                return &it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename A, typename B>
+    static bool StartsWith(const A& key, const B& prefix) {
+        return key.size() >= prefix.size() && std::equal(prefix.begin(), prefix.end(), key.begin());
+    }
+
+    // Sum of the write counters below, any write there changes it
+    uint64_t ParentGeneration() const {
+        uint64_t sum{};
+        for (auto layer = parent; layer; layer = layer->parent) {
+            sum += layer->generation.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    template<typename T>
+    void Assign(const TBytes& key, T&& value) {
+        generation.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::unique_lock lock{decodedMutex};
+            if (!decoded.empty()) {
+                if (auto it = decoded.find(key); it != decoded.end()) {
+                    decoded.erase(it);
+                }
+            }
+            for (auto it = decodedPrefixes.begin(); it != decodedPrefixes.end();) {
+                StartsWith(key, it->first) ? decodedPrefixes.erase(it++) : ++it;
+            }
+        }
+        auto it = changed.lower_bound(key);
+        if (it != changed.end() && CompareKeyBytes(key, it->first) == 0) {
+            it->second = std::forward<T>(value);
+        } else {
+            changed.emplace_hint(it, ToKeyBytes(key), std::forward<T>(value));
+        }
+    }
+
     std::unique_ptr<CStorageLevelDB> snapshotDB;
     CStorageKV& db;
-    MapKV changed;
+    ArenaMapKV changed;
+    // Changes of the block the snapshot was taken at
+    std::shared_ptr<const ArenaMapKV> snapshotChanged;
+
+    // Layer below when stacked on another flushable storage
+    CFlushableStorageKV* parent{};
+    // Number of writes to this layer
+    std::atomic<uint64_t> generation{0};
+    mutable AtomicMutex decodedMutex;
+    mutable std::map<TKeyBytes, DecodedEntry, KeyBytesLess> decoded;
+    mutable std::map<TKeyBytes, DecodedEntry, KeyBytesLess> decodedPrefixes;
 
     // Whether this view is using a snapshot
     bool snapshot{};
 };
 
+// Reads made through a CRecordingStorageKV together with what they returned
+class CStorageKVReads {
+public:
+    // Whether every read gives the same result on the storage
+    bool Validate(CStorageKV& other) const {
+        TBytes value;
+        for (const auto& [key, result] : reads) {
+            const auto found = other.Read(key, value);
+            if (found != bool(result) || (found && value != *result)) {
+                return false;
+            }
+        }
+        // A decoded object is dropped by any write to its keys
+        for (const auto& [key, type, prefix, object] : decoded) {
+            if (other.GetDecoded(key, type, prefix) != object) {
+                return false;
+            }
+        }
+        for (const auto& steps : iterators) {
+            const auto it = other.NewIterator();
+            for (const auto& step : steps) {
+                if (step.op == IteratorStep::Seek) {
+                    it->Seek(step.seekKey);
+                } else if (step.op == IteratorStep::Next) {
+                    it->Next();
+                } else {
+                    it->Prev();
+                }
+                if (it->Valid() != step.valid) {
+                    return false;
+                }
+                if (step.valid && (!ViewEquals(it->KeyView(), step.key) || !ViewEquals(it->ValueView(), step.value))) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    friend class CRecordingStorageKV;
+
+    struct IteratorStep {
+        enum Op : uint8_t { Seek, Next, Prev };
+        Op op;
+        TBytes seekKey;
+        bool valid;
+        TBytes key;
+        TBytes value;
+    };
+
+    struct DecodedRead {
+        TBytes key;
+        std::type_index type;
+        bool prefix;
+        std::shared_ptr<const void> object;
+    };
+
+    static bool ViewEquals(TBytesView view, const TBytes& bytes) {
+        return static_cast<size_t>(view.size()) == bytes.size() && std::equal(view.begin(), view.end(), bytes.begin());
+    }
+
+    // First result of each key, the storage below doesn't change while recording
+    std::map<TBytes, std::optional<TBytes>> reads;
+    // Iterators are kept in a list as their steps are referenced while they are alive
+    std::list<std::vector<IteratorStep>> iterators;
+    // Objects handed out by the decoded cache below, instead of their reads
+    std::vector<DecodedRead> decoded;
+};
+
+// Forwards the reads to a storage and records what they returned, so that
+// it can be checked whether the same reads give the same answers on another
+// state. Writes are not supported, changes belong to a view stacked on top.
+class CRecordingStorageKV : public CStorageKV {
+    using IteratorStep = CStorageKVReads::IteratorStep;
+
+    class RecordingIterator : public CStorageKVIterator {
+    public:
+        RecordingIterator(std::unique_ptr<CStorageKVIterator> it, std::vector<IteratorStep>& steps) : it(std::move(it)), steps(steps) {}
+        ~RecordingIterator() override = default;
+
+        void Seek(const TBytes& key) override {
+            it->Seek(key);
+            Record(IteratorStep::Seek, key);
+        }
+        void Next() override {
+            it->Next();
+            Record(IteratorStep::Next);
+        }
+        void Prev() override {
+            it->Prev();
+            Record(IteratorStep::Prev);
+        }
+        bool Valid() override {
+            return it->Valid();
+        }
+        TBytesView KeyView() override {
+            return it->KeyView();
+        }
+        TBytesView ValueView() override {
+            return it->ValueView();
+        }
+
+    private:
+        void Record(IteratorStep::Op op, const TBytes& seekKey = {}) {
+            IteratorStep step{op, seekKey, it->Valid(), {}, {}};
+            if (step.valid) {
+                step.key = it->Key();
+                step.value = it->Value();
+            }
+            steps.push_back(std::move(step));
+        }
+
+        std::unique_ptr<CStorageKVIterator> it;
+        std::vector<IteratorStep>& steps;
+    };
+
+public:
+    explicit CRecordingStorageKV(CStorageKV& db) : db(db) {}
+    CRecordingStorageKV(const CRecordingStorageKV&) = delete;
+    ~CRecordingStorageKV() override = default;
+
+    bool Exists(const TBytes& key) const override {
+        TBytes value;
+        return Read(key, value);
+    }
+    bool Write(const TBytes&, const TBytes&) override {
+        throw std::runtime_error("Cannot Write to a recording storage");
+    }
+    bool Erase(const TBytes&) override {
+        throw std::runtime_error("Cannot Erase from a recording storage");
+    }
+    bool Read(const TBytes& key, TBytes& value) const override {
+        const auto found = db.Read(key, value);
+        std::optional<TBytes> result;
+        if (found) {
+            result = value;
+        }
+        recorded.reads.emplace(key, std::move(result));
+        return found;
+    }
+    // Resolved by the decoded cache below, a miss is read through this storage
+    std::shared_ptr<const void> GetDecoded(const TBytes& key, std::type_index type, bool prefix) const override {
+        auto object = db.GetDecoded(key, type, prefix);
+        if (object) {
+            recorded.decoded.push_back({key, type, prefix, object});
+        }
+        return object;
+    }
+    std::unique_ptr<CStorageKVIterator> NewIterator() override {
+        auto& steps = recorded.iterators.emplace_back();
+        return std::make_unique<RecordingIterator>(db.NewIterator(), steps);
+    }
+    size_t SizeEstimate() const override {
+        return 0;
+    }
+    bool Flush() override {
+        return true;
+    }
+
+    const CStorageKVReads& GetReads() const {
+        return recorded;
+    }
+    // Only once the iterators are gone
+    CStorageKVReads TakeReads() {
+        return std::move(recorded);
+    }
+
+private:
+    CStorageKV& db;
+    mutable CStorageKVReads recorded;
+};
+
 template<typename T>
 class CLazySerialize {
     std::optional<T> value;
@@ -408,7 +833,7 @@ public:
     const T& get() {
         if (!value) {
             value = T{};
-            BytesToDbType(it->Value(), *value);
+            BytesToDbType(it->ValueView(), *value);
         }
         return *value;
     }
@@ -421,7 +846,13 @@ class CStorageIteratorWrapper {
     std::unique_ptr<CStorageKVIterator> it;
 
     void UpdateValidity() {
-        valid = it->Valid() && BytesToDbType(it->Key(), key) && key.first == By::prefix();
+        if (!it->Valid()) {
+            valid = false;
+            return;
+        }
+        // check the prefix byte before decoding the rest of the key
+        const auto rawKey = it->KeyView();
+        valid = rawKey.size() > 0 && rawKey[0] == By::prefix() && BytesToDbType(rawKey, key);
     }
 
     struct Resolver {
@@ -480,13 +911,13 @@ public:
     template<typename T>
     bool Value(T& value) {
         assert(Valid());
-        return BytesToDbType(it->Value(), value);
+        return BytesToDbType(it->ValueView(), value);
     }
 };
 
 // Creates an iterator to single level key value storage
 template<typename By, typename KeyType>
-CStorageIteratorWrapper<By, KeyType> NewKVIterator(const KeyType& key, MapKV& map) {
+CStorageIteratorWrapper<By, KeyType> NewKVIterator(const KeyType& key, ArenaMapKV& map) {
     auto emptyParent = std::make_unique<CStorageKVEmptyIterator>();
     auto flushableIterator = std::make_unique<CFlushableStorageKVIterator>(std::move(emptyParent), map);
     CStorageIteratorWrapper<By, KeyType> it{std::move(flushableIterator)};
@@ -553,6 +984,52 @@ public:
             return result;
         return {};
     }
+    // Decodes a value once and shares it until the key is written again.
+    // The object is shared between views and must not be modified.
+    template<typename ResultType, typename KeyType>
+    std::shared_ptr<const ResultType> ReadCached(const KeyType& key) const {
+        auto vKey = DbTypeToBytes(key);
+        const auto flushable = dynamic_cast<const CFlushableStorageKV*>(&DB());
+        if (flushable) {
+            if (auto object = flushable->GetDecoded(vKey, typeid(ResultType))) {
+                decodedCacheStats.hits.fetch_add(1, std::memory_order_relaxed);
+                return std::static_pointer_cast<const ResultType>(object);
+            }
+        }
+        decodedCacheStats.misses.fetch_add(1, std::memory_order_relaxed);
+        TBytes vValue;
+        auto result = std::make_shared<ResultType>();
+        if (!DB().Read(vKey, vValue) || !BytesToDbType(vValue, *result)) {
+            return {};
+        }
+        if (flushable) {
+            flushable->SetDecoded(vKey, typeid(ResultType), result);
+        }
+        return result;
+    }
+    template<typename By, typename ResultType, typename KeyType>
+    std::shared_ptr<const ResultType> ReadCachedBy(const KeyType& key) const {
+        return ReadCached<ResultType>(std::make_pair(By::prefix(), key));
+    }
+    // Same as ReadCached for an object built from all the keys of a prefix,
+    // a write to any of them drops the cached object.
+    template<typename By, typename ResultType, typename Builder>
+    std::shared_ptr<const ResultType> ReadCachedPrefix(Builder&& build) const {
+        const auto vPrefix = DbTypeToBytes(By::prefix());
+        const auto flushable = dynamic_cast<const CFlushableStorageKV*>(&DB());
+        if (flushable) {
+            if (auto object = flushable->GetDecoded(vPrefix, typeid(ResultType), true)) {
+                decodedCacheStats.hits.fetch_add(1, std::memory_order_relaxed);
+                return std::static_pointer_cast<const ResultType>(object);
+            }
+        }
+        decodedCacheStats.misses.fetch_add(1, std::memory_order_relaxed);
+        auto result = std::make_shared<const ResultType>(build());
+        if (flushable) {
+            flushable->SetDecoded(vPrefix, typeid(ResultType), result, true);
+        }
+        return result;
+    }
     template<typename By, typename KeyType>
     CStorageIteratorWrapper<By, KeyType> LowerBound(KeyType const & key) {
         CStorageIteratorWrapper<By, KeyType> it{DB().NewIterator()};
@@ -7,6 +7,7 @@
 #include <chainparams.h>
 #include <crypto/hmac_sha256.h>
 #include <httpserver.h>
+#include <rpc/jsonstream.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <rpc/stats.h>
@@ -217,26 +218,71 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         auto func = [&](const std::string& h) { return req->GetHeader(h); };
         RPCMetadata::FromHTTPHeader(jreq.metadata, func);
 
-        std::string strReply;
+        size_t replySize{};
         // singleton request
         if (valRequest.isObject()) {
             jreq.parse(valRequest);
 
-            UniValue result = tableRPC.execute(jreq);
+            // The reply is written as it is produced and goes out in chunks once large
+            bool chunked{false};
+            CJSONStreamWriter writer([&](std::string&& chunk) {
+                if (!chunked) {
+                    req->WriteHeader("Content-Type", "application/json");
+                    req->StartReplyChunked(HTTP_OK);
+                    chunked = true;
+                }
+                req->WriteReplyChunk(std::move(chunk));
+            });
+            writer.BeginObject();
+            writer.Key("result");
+
+            // Cached results are spliced into the reply by the table as they were serialized
+            jreq.resultStream = &writer;
+            try {
+                const auto size = writer.Size();
+                UniValue result = tableRPC.execute(jreq);
+                // Unless the handler or the cache wrote the result already
+                if (writer.Size() == size) {
+                    writer.Value(result);
+                }
+            } catch (...) {
+                if (chunked) {
+                    // The status went out with the first chunk, drop the connection
+                    // so that the client can't take the partial reply as complete
+                    LogPrintf("%s: %s failed while streaming its result\n", __func__, jreq.strMethod);
+                    req->AbortReplyChunked();
+                    if (statsRPC.isActive()) statsRPC.add(jreq.strMethod, GetTimeMillis() - time, writer.Size(), true);
+                    return false;
+                }
+                throw;
+            }
 
             // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            writer.Key("error");
+            writer.Null();
+            writer.Key("id");
+            writer.Value(jreq.id);
+            writer.EndObject();
+            writer.Raw("\n");
+            if (chunked) {
+                writer.Flush();
+                req->EndReplyChunked();
+            } else {
+                req->WriteHeader("Content-Type", "application/json");
+                req->WriteReply(HTTP_OK, writer.Release());
+            }
+            replySize = writer.Size();
 
         // array of requests
-        } else if (valRequest.isArray())
-            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
-        else
+        } else if (valRequest.isArray()) {
+            std::string strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
+            req->WriteHeader("Content-Type", "application/json");
+            req->WriteReply(HTTP_OK, strReply);
+            replySize = strReply.length();
+        } else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
 
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strReply);
-
-        if (statsRPC.isActive()) statsRPC.add(jreq.strMethod, GetTimeMillis() - time, strReply.length());
+        if (statsRPC.isActive()) statsRPC.add(jreq.strMethod, GetTimeMillis() - time, replySize);
     } catch (const UniValue& objError) {
         JSONErrorReply(req, objError, jreq.id);
         return false;
@@ -15,8 +15,10 @@
 #include <sync.h>
 #include <ui_interface.h>
 
+#include <condition_variable>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
@@ -43,6 +45,9 @@
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
 
+/** Maximum bytes of a chunked reply handed to libevent but not sent yet */
+static const size_t MAX_CHUNKED_REPLY_IN_FLIGHT = 1024 * 1024;
+
 /** HTTP request work item */
 class HTTPWorkItem final : public HTTPClosure
 {
@@ -149,6 +154,8 @@ static WorkQueue<HTTPClosure>* workQueue = nullptr;
 static std::vector<HTTPPathHandler> pathHandlers;
 //! Bound listening sockets
 static std::vector<evhttp_bound_socket *> boundSockets;
+//! Time a client may take no part of a chunked reply before it is aborted
+static std::chrono::seconds chunkedReplyTimeout{DEFAULT_HTTP_SERVER_TIMEOUT};
 
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr& netaddr)
@@ -407,6 +414,7 @@ bool InitHTTPServer()
     allowed_methods |= EVHTTP_REQ_PUT | EVHTTP_REQ_DELETE | EVHTTP_REQ_OPTIONS;
 
     evhttp_set_timeout(http, gArgs.GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT));
+    chunkedReplyTimeout = std::chrono::seconds{gArgs.GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT)};
     evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
     evhttp_set_max_body_size(http, MAX_DESER_SIZE);
     evhttp_set_allowed_methods(http, allowed_methods);
@@ -533,11 +541,16 @@ void HTTPEvent::trigger(struct timeval* tv)
         evtimer_add(ev, tv); // trigger after timeval passed
 }
 HTTPRequest::HTTPRequest(struct evhttp_request* _req) : req(_req),
-                                                       replySent(false)
+                                                       replySent(false),
+                                                       replyChunked(false)
 {
 }
 HTTPRequest::~HTTPRequest()
 {
+    if (replyChunked && req) {
+        // A chunked reply left open, e.g. by an exception, is incomplete
+        AbortReplyChunked();
+    }
     if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
@@ -584,6 +597,21 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
     evhttp_add_header(headers, hdr.c_str(), value.c_str());
 }
 
+// Re-enable reading from the socket. This is the second part of the libevent
+// workaround in http_request_cb.
+static void EnableReading(struct evhttp_request* req)
+{
+    if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+        evhttp_connection* conn = evhttp_request_get_connection(req);
+        if (conn) {
+            bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
 /** Closure sent to main thread to request a reply to be sent to
  * a HTTP request.
  * Replies must be sent in the main loop in the main http thread,
@@ -602,20 +630,125 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-        // Re-enable reading from the socket. This is the second part of the libevent
-        // workaround above.
-        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
-            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
-            if (conn) {
-                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
-                if (bev) {
-                    bufferevent_enable(bev, EV_READ | EV_WRITE);
-                }
+        EnableReading(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
+/** Bytes of a chunked reply that are queued but not written to the socket */
+struct HTTPChunkedReply
+{
+    std::mutex m;
+    std::condition_variable cv;
+    size_t inFlight{0};
+};
+
+/** Chunk added to an evbuffer by reference, freed when libevent is done with it */
+struct HTTPReplyChunk
+{
+    std::shared_ptr<HTTPChunkedReply> reply;
+    std::string data;
+};
+
+static void ReleaseReplyChunk(const void*, size_t, void* arg)
+{
+    std::unique_ptr<HTTPReplyChunk> chunk{static_cast<HTTPReplyChunk*>(arg)};
+    {
+        std::lock_guard<std::mutex> l{chunk->reply->m};
+        chunk->reply->inFlight -= chunk->data.size();
+    }
+    chunk->reply->cv.notify_all();
+}
+
+/** The chunks are sent from the main http thread as well, in the order they
+ * were written, as events triggered from one thread run in order.
+ */
+void HTTPRequest::StartReplyChunked(int nStatus)
+{
+    assert(!replySent && req);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    replyChunked = true;
+    chunkedReply = std::make_shared<HTTPChunkedReply>();
+}
+
+void HTTPRequest::WriteReplyChunk(std::string&& chunk)
+{
+    assert(replyChunked && req);
+    if (chunk.empty()) {
+        // An empty chunk would end the reply
+        return;
+    }
+    {
+        // Waits for the client to take the earlier chunks. Gives up when it
+        // takes none of them for the server timeout, and stops waiting on
+        // shutdown, when the event loop may no longer send them.
+        std::unique_lock<std::mutex> l{chunkedReply->m};
+        auto inFlight = chunkedReply->inFlight;
+        auto deadline = std::chrono::steady_clock::now() + chunkedReplyTimeout;
+        while (chunkedReply->inFlight && chunkedReply->inFlight + chunk.size() > MAX_CHUNKED_REPLY_IN_FLIGHT &&
+               !ShutdownRequested()) {
+            const auto now = std::chrono::steady_clock::now();
+            if (chunkedReply->inFlight < inFlight) {
+                inFlight = chunkedReply->inFlight;
+                deadline = now + chunkedReplyTimeout;
+            } else if (now >= deadline) {
+                throw std::runtime_error("Client stopped reading the reply");
             }
+            chunkedReply->cv.wait_for(l, std::chrono::milliseconds{100});
+        }
+        chunkedReply->inFlight += chunk.size();
+    }
+    auto req_copy = req;
+    auto data = new HTTPReplyChunk{chunkedReply, std::move(chunk)};
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, data]{
+        struct evbuffer* evb = evbuffer_new();
+        assert(evb);
+        // Moved to the connection's output without a copy and released once sent
+        evbuffer_add_reference(evb, data->data.data(), data->data.size(), ReleaseReplyChunk, data);
+        evhttp_send_reply_chunk(req_copy, evb);
+        evbuffer_free(evb);
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::EndReplyChunked()
+{
+    assert(replyChunked && req);
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy]{
+        evhttp_send_reply_end(req_copy);
+        EnableReading(req_copy);
+    });
+    ev->trigger(nullptr);
+    req = nullptr; // transferred back to main thread
+}
+
+void HTTPRequest::AbortReplyChunked()
+{
+    assert(replyChunked && req);
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy]{
+        // Without the terminating chunk the client sees the reply is incomplete.
+        // Freeing the connection frees the request with it, and there is no
+        // reading left to re-enable. A request whose connection failed was
+        // detached from it and left to us, so it is freed on its own.
+        if (evhttp_connection* conn = evhttp_request_get_connection(req_copy)) {
+            evhttp_connection_free(conn);
+        } else {
+            evhttp_request_free(req_copy);
         }
     });
     ev->trigger(nullptr);
-    replySent = true;
     req = nullptr; // transferred back to main thread
 }
 
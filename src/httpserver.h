@@ -8,6 +8,7 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <memory>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -17,6 +18,7 @@ struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+struct HTTPChunkedReply;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -59,6 +61,8 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    bool replyChunked;
+    std::shared_ptr<HTTPChunkedReply> chunkedReply;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req);
@@ -115,6 +119,23 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Write HTTP reply in chunks, with chunked transfer encoding.
+     * StartReplyChunked sends the status and the headers, each WriteReplyChunk
+     * sends a part of the body and EndReplyChunked completes the reply.
+     * WriteReplyChunk blocks while too much of the body waits for the client,
+     * and throws when the client takes none of it for -rpcservertimeout.
+     * AbortReplyChunked closes the connection without completing the reply,
+     * so the client can tell it is cut short.
+     *
+     * @note Use instead of WriteReply. After EndReplyChunked or
+     * AbortReplyChunked, do not call any other HTTPRequest methods.
+     */
+    void StartReplyChunked(int nStatus);
+    void WriteReplyChunk(std::string&& chunk);
+    void EndReplyChunked();
+    void AbortReplyChunked();
 };
 
 /** Event handler closure.
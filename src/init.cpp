@@ -28,6 +28,8 @@
 #include <dfi/anchors.h>
 #include <dfi/govvariables/attributes.h>
 #include <dfi/masternodes.h>
+#include <dfi/processstats.h>
+#include <dfi/speculativetx.h>
 #include <dfi/vaulthistory.h>
 #include <dfi/threadpool.h>
 #include <miner.h>
@@ -541,6 +543,7 @@ void SetupServerArgs()
     gArgs.AddArg("-txordering", strprintf("Whether to order transactions by entry time, fee or both randomly (0: mixed, 1: fee based, 2: entry time) (default: %u)", DEFAULT_TX_ORDERING), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-ethstartstate", strprintf("Initialise Ethereum state trie using JSON input"), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-enablesnapshots", strprintf("Whether to enable snapshot on each block (default: %u)", DEFAULT_SNAPSHOT), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-stakerprepare", strprintf("Assemble a block template between kernel searches, so that the block of a found kernel reuses the custom transactions applied for it (default: %u)", DEFAULT_STAKER_PREPARE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-ascendingstaketime", strprintf("Test staking forward in time from the current block"), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #ifdef USE_UPNP
 #if USE_UPNP
@@ -661,10 +664,12 @@ void SetupServerArgs()
     gArgs.AddArg("-server", "Accept command line and JSON-RPC commands", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     gArgs.AddArg("-rpcallowcors=<host>", "Allow CORS requests from the given host origin. Include scheme and port (eg: -rpcallowcors=http://127.0.0.1:5000)", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     gArgs.AddArg("-rpcstats", strprintf("Log RPC stats. (default: %u)", DEFAULT_RPC_STATS), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    gArgs.AddArg("-defiprocessstats=<n>", strprintf("Keep the timings and counters of the DeFi processing of the last <n> connected blocks for getdefiprocessstats, 0 to disable (default: %u)", DEFAULT_DEFI_PROCESS_STATS), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     gArgs.AddArg("-consolidaterewards=<token-or-pool-symbol>", "Consolidate rewards on startup. Accepted multiple times for each token symbol", ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-rpccache=<0/1/2>", "Cache rpc results - uses additional memory to hold on to the last results per block, but faster (0=none, 1=all, 2=smart)", ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-negativeinterest", "(experimental) Track negative interest values", ArgsManager::ALLOW_ANY, OptionsCategory::HIDDEN);
     gArgs.AddArg("-rpc-governance-accept-neutral", "Allow voting with neutral votes for JellyFish purpose", ArgsManager::ALLOW_ANY, OptionsCategory::HIDDEN);
+    gArgs.AddArg("-parallelcustomtx=<mode>", strprintf("Run the account and pool transactions of a block, and of the mempool when it is refreshed after a block, in parallel ahead of applying them in order (off, on, shadow: apply serially and log differences) (default: %s)", DEFAULT_PARALLEL_CUSTOM_TX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-dftxworkers=<n>", strprintf("No. of parallel workers associated with the DfTx related work pool. Stock splits, parallel processing of the chain where appropriate, etc use this worker pool (default: %d)", DEFAULT_DFTX_WORKERS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-maxaddrratepersecond=<n>", strprintf("Sets MAX_ADDR_RATE_PER_SECOND limit for ADDR messages(default: %f)", MAX_ADDR_RATE_PER_SECOND), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     gArgs.AddArg("-maxaddrprocessingtokenbucket=<n>", strprintf("Sets MAX_ADDR_PROCESSING_TOKEN_BUCKET limit for ADDR messages(default: %d)", MAX_ADDR_PROCESSING_TOKEN_BUCKET), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
@@ -928,7 +933,6 @@ static bool AppInitServers()
         default: return RPCResultCache::RPCCacheMode::None;
     }}();
     GetRPCResultCache().Init(rpcCacheMode);
-    GetMemoizedResultCache().Init(rpcCacheMode);
 
     RPCServer::OnStarted(&OnRPCStarted);
     RPCServer::OnStopped(&OnRPCStopped);
@@ -1161,6 +1165,15 @@ bool AppInitParameterInteraction()
         }
     }
 
+    const std::string parallel_custom_tx = gArgs.GetArg("-parallelcustomtx", DEFAULT_PARALLEL_CUSTOM_TX);
+    if (const auto mode = ParseParallelCustomTxMode(parallel_custom_tx)) {
+        g_parallel_custom_tx_mode = *mode;
+    } else {
+        return InitError(strprintf(_("Unknown -parallelcustomtx value %s.").translated, parallel_custom_tx));
+    }
+
+    deFiProcessStats.SetHistorySize(std::max<int64_t>(gArgs.GetArg("-defiprocessstats", DEFAULT_DEFI_PROCESS_STATS), 0));
+
     // if using block pruning, then disallow txindex
     if (gArgs.GetArg("-prune", 0)) {
         if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
@@ -1750,12 +1763,12 @@ void SetupInterrupts() {
     fInterrupt = SetupInterruptArg("-interrupt-block", fInterruptBlockHash, fInterruptBlockHeight);
 }
 
-bool OceanIndex (const UniValue b) {
+bool OceanIndex (const std::string &b) {
     CrossBoundaryResult result;
-    ocean_index_block(result, b.write());
+    ocean_index_block(result, b);
     if (!result.ok) {
         LogPrintf("Error indexing genesis block: %s\n", result.reason);
-        ocean_invalidate_block(result, b.write());
+        ocean_invalidate_block(result, b);
         if (!result.ok) {
             LogPrintf("Error invalidating genesis block: %s\n", result.reason);
             return false;
@@ -1982,6 +1995,7 @@ bool AppInitMain(InitInterfaces& interfaces)
                 pburnHistoryDB.reset();
                 pburnHistoryDB = std::make_unique<CBurnHistoryStorage>(GetDataDir() / "burn", nCacheSizes.customCacheSize, false, fReset || fReindexChainState);
                 pburnHistoryDB->CreateMultiIndexIfNeeded();
+                pburnHistoryDB->CreateTotalsIfNeeded();
 
                 // Create vault history DB
                 pvaultHistoryDB.reset();
@@ -2527,7 +2541,7 @@ bool AppInitMain(InitInterfaces& interfaces)
             tip = ::ChainActive().Tip();
         }
 
-        const UniValue b = blockToJSON(*pcustomcsview, block, tip, pblockindex, true, 2);
+        const auto b = blockToJSON(*pcustomcsview, block, tip, pblockindex, true, 2).write();
 
         if (bool isIndexed = OceanIndex(b); !isIndexed) {
             return false;
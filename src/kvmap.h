@@ -0,0 +1,78 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_KVMAP_H
+#define DEFI_KVMAP_H
+
+#include <prevector.h>
+#include <support/allocators/pool.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <vector>
+
+using TBytes = std::vector<unsigned char>;
+using MapKV = std::map<TBytes, std::optional<TBytes>>;
+
+// Keys up to this size are stored inline in the map node. This covers the
+// prefixed balance, undo, history and pool keys, so the dirty set of a view
+// needs no heap allocation for the key in the common case.
+static constexpr unsigned int KV_KEY_INLINE_SIZE = 44;
+
+using TKeyBytes = prevector<KV_KEY_INLINE_SIZE, unsigned char>;
+
+// Lexicographical byte-wise comparison, same ordering as std::vector<unsigned char>
+// and LevelDB's default comparator.
+template<typename A, typename B>
+inline int CompareKeyBytes(const A& a, const B& b) {
+    const auto aSize = static_cast<size_t>(a.size());
+    const auto bSize = static_cast<size_t>(b.size());
+    const auto size = std::min(aSize, bSize);
+    if (size) {
+        if (auto res = std::memcmp(a.data(), b.data(), size)) {
+            return res;
+        }
+    }
+    return aSize < bSize ? -1 : aSize > bSize;
+}
+
+// Transparent comparators so that TBytes can be used to look up TKeyBytes and vice versa
+struct KeyBytesLess {
+    using is_transparent = void;
+
+    template<typename A, typename B>
+    bool operator()(const A& a, const B& b) const {
+        return CompareKeyBytes(a, b) < 0;
+    }
+};
+
+struct KeyBytesGreater {
+    using is_transparent = void;
+
+    template<typename A, typename B>
+    bool operator()(const A& a, const B& b) const {
+        return CompareKeyBytes(a, b) > 0;
+    }
+};
+
+inline TKeyBytes ToKeyBytes(const TBytes& bytes) {
+    return TKeyBytes(bytes.begin(), bytes.end());
+}
+
+inline TBytes FromKeyBytes(const TKeyBytes& key) {
+    return TBytes(key.begin(), key.end());
+}
+
+using ArenaMapKVValue = std::pair<const TKeyBytes, std::optional<TBytes>>;
+
+// Ordered dirty set of a flushable storage layer. Nodes are carved out of
+// per-map arena chunks instead of being allocated one by one; iterators stay
+// valid on insertion, which CFlushableStorageKVIterator relies on when a view
+// is written to while it is being iterated.
+using ArenaMapKV = std::map<TKeyBytes, std::optional<TBytes>, KeyBytesLess,
+                            PoolAllocator<ArenaMapKVValue, sizeof(ArenaMapKVValue) + sizeof(void*) * 4, alignof(void*), 1 << 15>>;
+
+#endif // DEFI_KVMAP_H
@@ -6,6 +6,7 @@
 #define DEFI_MEMUSAGE_H
 
 #include <indirectmap.h>
+#include <support/allocators/pool.h>
 
 #include <stdlib.h>
 
@@ -117,6 +118,19 @@ static inline size_t IncrementalDynamicUsage(const std::map<X, Y, Z>& m)
     return MallocUsage(sizeof(stl_tree_node<std::pair<const X, Y> >));
 }
 
+template<typename X, typename Y, typename Z, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES, std::size_t CHUNK_SIZE_BYTES>
+static inline size_t DynamicUsage(const std::map<X, Y, Z, PoolAllocator<std::pair<const X, Y>, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES, CHUNK_SIZE_BYTES>>& m)
+{
+    // nodes live in the pool's chunks, so the chunks are what is actually allocated
+    auto allocator = m.get_allocator();
+    auto pool_resource = allocator.resource();
+    if (!pool_resource) {
+        return 0;
+    }
+    size_t estimated_list_node_size = MallocUsage(sizeof(void*) * 3);
+    return (estimated_list_node_size + MallocUsage(pool_resource->ChunkSizeBytes())) * pool_resource->NumAllocatedChunks();
+}
+
 // indirectmap has underlying map with pointer as key
 
 template<typename X, typename Y>
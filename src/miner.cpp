@@ -19,6 +19,7 @@
 #include <dfi/govvariables/attributes.h>
 #include <dfi/masternodes.h>
 #include <dfi/mn_checks.h>
+#include <dfi/speculativetx.h>
 #include <dfi/validation.h>
 #include <ffi/cxx.h>
 #include <ffi/ffiexports.h>
@@ -39,6 +40,7 @@
 
 #include <algorithm>
 #include <random>
+#include <tuple>
 #include <utility>
 
 #include <boost/lockfree/queue.hpp>
@@ -98,6 +100,11 @@ static BlockAssembler::Options DefaultOptions() {
 BlockAssembler::BlockAssembler(const CChainParams &params)
     : BlockAssembler(params, DefaultOptions()) {}
 
+BlockAssembler::BlockAssembler(const CChainParams &params, CTemplateTxResults *templateTxResults)
+    : BlockAssembler(params, DefaultOptions()) {
+    this->templateTxResults = templateTxResults;
+}
+
 void BlockAssembler::resetBlock() {
     inBlock.clear();
 
@@ -340,6 +347,85 @@ static void AddSplitDVMTxs(CCustomCSView &mnview,
     }
 }
 
+static Res ApplyTemplateTx(BlockContext &blockCtx,
+                           CCustomCSView &view,
+                           const CCoinsViewCache &coins,
+                           const CTransaction &tx) {
+    auto txCtx = TransactionContext{
+        coins,
+        tx,
+        blockCtx,
+    };
+    BlockContext blockCtxTxView{blockCtx, view};
+    return ApplyCustomTx(blockCtxTxView, txCtx);
+}
+
+void CTemplateTxResults::SetTip(const uint256 &hash) {
+    if (tip != hash) {
+        tip = hash;
+        results.clear();
+    }
+}
+
+Res CTemplateTxResults::Apply(BlockContext &blockCtx,
+                              CCustomCSView &view,
+                              const CCoinsViewCache &coins,
+                              const CTransaction &tx) {
+    auto txCtx = TransactionContext{
+        coins,
+        tx,
+        blockCtx,
+    };
+
+    // Auth checks skip the inputs which aren't found
+    const auto withSwaps = !gArgs.GetBoolArg("-oceanarchive", DEFAULT_OCEAN_INDEXER_ENABLED);
+    const auto reusable = IsSpeculativeCustomTxType(txCtx.GetTxType(), withSwaps) &&
+                          std::none_of(tx.vin.begin(), tx.vin.end(), [&](const CTxIn &input) {
+                              return coins.AccessCoin(input.prevout).IsSpent();
+                          });
+    if (!reusable) {
+        return ApplyTemplateTx(blockCtx, view, coins, tx);
+    }
+
+    auto &storage = view.GetStorage();
+    if (auto it = results.find(tx.GetHash()); it != results.end() && it->second.reads.Validate(storage)) {
+        for (const auto &[key, value] : it->second.changes) {
+            if (value) {
+                storage.Write(key, *value);
+            } else {
+                storage.Erase(key);
+            }
+        }
+        return it->second.res;
+    }
+
+    CRecordingStorageKV reads(storage);
+    Result result;
+    {
+        CCustomCSView txView(reads);
+        BlockContext blockCtxTxView{blockCtx, txView};
+        result.res = ApplyCustomTx(blockCtxTxView, txCtx);
+        if (!result.res) {
+            return result.res;
+        }
+        for (const auto &[changedKey, value] : txView.GetStorage().GetRaw()) {
+            auto key = FromKeyBytes(changedKey);
+            if (value) {
+                storage.Write(key, *value);
+            } else {
+                storage.Erase(key);
+            }
+            result.changes.emplace_back(std::move(key), value);
+        }
+    }
+    const auto res = result.res;
+    if (results.size() < MAX_RESULTS) {
+        result.reads = reads.TakeReads();
+        results.insert_or_assign(tx.GetHash(), std::move(result));
+    }
+    return res;
+}
+
 ResVal<std::unique_ptr<CBlockTemplate>> BlockAssembler::CreateNewBlock(const CScript &scriptPubKeyIn,
                                                                        int64_t blockTime,
                                                                        const std::string &evmBeneficiary) {
@@ -511,6 +597,9 @@ ResVal<std::unique_ptr<CBlockTemplate>> BlockAssembler::CreateNewBlock(const CSc
 
     std::map<uint256, CAmount> txFees;
 
+    if (templateTxResults) {
+        templateTxResults->SetTip(pindexPrev->GetBlockHash());
+    }
     if (timeOrdering) {
         addPackageTxs<entry_time>(nPackagesSelected, nDescendantsUpdated, nHeight, txFees, blockCtx);
     } else {
@@ -1084,16 +1173,8 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected,
                     }
                 }
 
-                auto txCtx = TransactionContext{
-                    coins,
-                    tx,
-                    blockCtx,
-                };
-
-                // Copy block context and update to cache view
-                BlockContext blockCtxTxView{blockCtx, cache};
-
-                const auto res = ApplyCustomTx(blockCtxTxView, txCtx);
+                const auto res = templateTxResults ? templateTxResults->Apply(blockCtx, cache, coins, tx)
+                                                   : ApplyTemplateTx(blockCtx, cache, coins, tx);
                 // Not okay invalidate, undo and skip
                 if (!res.ok) {
                     failedTxSet.insert(entry);
@@ -1227,45 +1308,103 @@ namespace pos {
         return Status::stakeReady;
     }
 
+    void Staker::prepareBlock(const CChainParams &chainparams,
+                              const uint256 &tipHash,
+                              const CScript &scriptPubKey,
+                              const int64_t blockTime,
+                              const std::string &evmBeneficiary) {
+        // Again on a new tip, or when the mempool changed since a while
+        const auto txsUpdated = mempool.GetTransactionsUpdated();
+        const auto now = GetTimeMillis();
+        if (tipHash == prepared->tip &&
+            (txsUpdated == prepared->txsUpdated || now - prepared->time < STAKER_PREPARE_INTERVAL_MS)) {
+            return;
+        }
+        prepared->tip = tipHash;
+        prepared->txsUpdated = txsUpdated;
+        prepared->time = now;
+
+        // The template itself is thrown away, the block for a found kernel
+        // takes over the results of the txs applied here
+        try {
+            auto res = BlockAssembler(chainparams, &prepared->txResults)
+                           .CreateNewBlock(scriptPubKey, blockTime, evmBeneficiary);
+            if (!res) {
+                LogPrint(BCLog::STAKING, "%s: %s\n", __func__, res.msg);
+            }
+        } catch (const std::runtime_error &e) {
+            LogPrint(BCLog::STAKING, "%s: %s\n", __func__, e.what());
+        }
+    }
+
     Staker::Status Staker::stake(const CChainParams &chainparams, const ThreadStaker::Args &args) {
+        size_t minter{};
+        return stake(chainparams, std::vector<ThreadStaker::Args>{args}, minter);
+    }
+
+    Staker::Status Staker::stake(const CChainParams &chainparams,
+                                 const std::vector<ThreadStaker::Args> &stakersArgs,
+                                 size_t &minter) {
         bool found = false;
 
-        const auto &operatorId = args.operatorID;
-        const auto &masternodeID = args.masternode;
-        const auto creationHeight = args.creationHeight;
-        const auto &scriptPubKey = args.coinbaseScript;
-        const auto subNode = args.subNode;
         CBlockIndex *tip{};
         int64_t blockHeight{};
-        uint32_t mintedBlocks{};
         int64_t blockTime{};
-        int64_t subNodeBlockTime{};
         bool ascendingEnabled{};
+        // Args of the active masternodes with their minted blocks and subnode block time
+        std::vector<std::tuple<size_t, uint32_t, int64_t>> active;
 
         {
             LOCK(cs_main);
             tip = ::ChainActive().Tip();
             blockHeight = tip->nHeight + 1;
             blockTime = std::max(tip->GetMedianTimePast() + 1, GetAdjustedTime());
-            const auto nodePtr = pcustomcsview->GetMasternode(masternodeID);
-            if (!nodePtr || !nodePtr->IsActive(blockHeight, *pcustomcsview)) {
-                return Status::initWaiting;
-            }
-            mintedBlocks = nodePtr->mintedBlocks;
-            const auto timeLock = pcustomcsview->GetTimelock(masternodeID, *nodePtr, blockHeight);
-            if (!timeLock) {
-                return Status::initWaiting;
+            for (size_t i = 0; i < stakersArgs.size(); ++i) {
+                const auto &args = stakersArgs[i];
+                const auto nodePtr = pcustomcsview->GetMasternode(args.masternode);
+                if (!nodePtr || !nodePtr->IsActive(blockHeight, *pcustomcsview)) {
+                    continue;
+                }
+                const auto timeLock = pcustomcsview->GetTimelock(args.masternode, *nodePtr, blockHeight);
+                if (!timeLock) {
+                    continue;
+                }
+                const auto subNodeBlockTime = pcustomcsview->GetBlockTimes(
+                    args.operatorID, blockHeight, args.creationHeight, *timeLock)[args.subNode];
+                active.emplace_back(i, nodePtr->mintedBlocks, subNodeBlockTime);
             }
-            subNodeBlockTime =
-                pcustomcsview->GetBlockTimes(operatorId, blockHeight, creationHeight, *timeLock)[subNode];
             const auto attributes = pcustomcsview->GetAttributes();
             CDataStructureV0 enabledKey{AttributeTypes::Param, ParamIDs::Feature, DFIPKeys::AscendingBlockTime};
             ascendingEnabled =
                 attributes->GetValue(enabledKey, false) || gArgs.GetBoolArg("-ascendingstaketime", false);
         }
 
+        if (active.empty()) {
+            return Status::initWaiting;
+        }
+
         auto nBits = pos::GetNextWorkRequired(tip, blockTime, chainparams.GetConsensus());
-        auto stakeModifier = pos::ComputeStakeModifier(tip->stakeModifier, args.minterKey.GetPubKey().GetID());
+
+        // One search for all the masternodes, a kernel index maps back to active
+        pos::CKernelSearch kernelSearch(nBits, blockHeight, chainparams.GetConsensus());
+        std::vector<uint256> stakeModifiers;
+        stakeModifiers.reserve(active.size());
+        for (const auto &[index, mintedBlocks, subNodeBlockTime] : active) {
+            const auto &args = stakersArgs[index];
+            stakeModifiers.push_back(
+                pos::ComputeStakeModifier(tip->stakeModifier, args.minterKey.GetPubKey().GetID()));
+            kernelSearch.AddCandidate(
+                {stakeModifiers.back(), args.creationHeight, args.masternode, subNodeBlockTime, args.subNode});
+        }
+
+        const auto getEvmBeneficiary = [](const CKey &minterKey) {
+            auto pubKey = minterKey.GetPubKey();
+            if (pubKey.IsCompressed()) {
+                pubKey.Decompress();
+            }
+            return pubKey.GetEthID().GetHex();
+        };
+        const auto prepareTime = blockTime;
 
         // Set search time if null or last block has changed
         if (!nLastCoinStakeSearchTime || lastBlockSeen != tip->GetBlockHash()) {
@@ -1288,94 +1427,90 @@ namespace pos {
             lastBlockSeen = tip->GetBlockHash();
         }
 
+        size_t kernelIndex{};
         withSearchInterval(
             [&](const int64_t currentTime, const int64_t lastSearchTime, const int64_t futureTime) {
-                // update last block creation attempt ts for the master node here
+                // update last block creation attempt ts for the master nodes here
                 {
                     std::unique_lock l{pos::cs_MNLastBlockCreationAttemptTs};
-                    pos::Staker::mapMNLastBlockCreationAttemptTs[masternodeID] = GetTime();
+                    for (const auto &entry : active) {
+                        pos::Staker::mapMNLastBlockCreationAttemptTs[stakersArgs[std::get<0>(entry)].masternode] =
+                            GetTime();
+                    }
                 }
-                CheckContextState ctxState{subNode};
+
+                std::vector<int64_t> times;
+                times.reserve(KERNEL_SEARCH_BATCH_SIZE);
+                const auto searchTimes = [&]() {
+                    const auto result = kernelSearch.Search(times);
+                    times.clear();
+                    if (result) {
+                        std::tie(blockTime, kernelIndex) = *result;
+                        LogPrint(BCLog::STAKING,
+                                 "MakeStake: kernel found. height: %d time: %d\n",
+                                 blockHeight,
+                                 blockTime);
+                        found = true;
+                    }
+                    std::this_thread::yield();  // give a slot to other threads
+                    return found || ShutdownRequested();
+                };
+
                 // Search backwards in time first
                 if (currentTime > lastSearchTime) {
                     for (uint32_t t = 0; t < currentTime - lastSearchTime; ++t) {
-                        if (ShutdownRequested()) {
+                        times.push_back(static_cast<uint32_t>(currentTime) - t);
+                        if (times.size() == KERNEL_SEARCH_BATCH_SIZE && searchTimes()) {
                             break;
                         }
-
-                        blockTime = (static_cast<uint32_t>(currentTime) - t);
-
-                        if (pos::CheckKernelHash(stakeModifier,
-                                                 nBits,
-                                                 creationHeight,
-                                                 blockTime,
-                                                 blockHeight,
-                                                 masternodeID,
-                                                 chainparams.GetConsensus(),
-                                                 subNodeBlockTime,
-                                                 ctxState)) {
-                            LogPrint(BCLog::STAKING,
-                                     "MakeStake: kernel found. height: %d time: %d\n",
-                                     blockHeight,
-                                     blockTime);
-
-                            found = true;
-                            break;
-                        }
-
-                        std::this_thread::yield();  // give a slot to other threads
+                    }
+                    if (!found && !times.empty()) {
+                        searchTimes();
                     }
                 }
 
-                if (!found) {
+                if (!found && !ShutdownRequested()) {
                     // Search from current time or lastSearchTime set in the future
                     int64_t searchTime = lastSearchTime > currentTime ? lastSearchTime : currentTime;
 
                     // Search forwards in time
                     for (uint32_t t = 1; t <= futureTime - searchTime; ++t) {
-                        if (ShutdownRequested()) {
+                        times.push_back(static_cast<uint32_t>(searchTime) + t);
+                        if (times.size() == KERNEL_SEARCH_BATCH_SIZE && searchTimes()) {
                             break;
                         }
-
-                        blockTime = (static_cast<uint32_t>(searchTime) + t);
-
-                        if (pos::CheckKernelHash(stakeModifier,
-                                                 nBits,
-                                                 creationHeight,
-                                                 blockTime,
-                                                 blockHeight,
-                                                 masternodeID,
-                                                 chainparams.GetConsensus(),
-                                                 subNodeBlockTime,
-                                                 ctxState)) {
-                            LogPrint(BCLog::STAKING,
-                                     "MakeStake: kernel found. height: %d time: %d\n",
-                                     blockHeight,
-                                     blockTime);
-
-                            found = true;
-                            break;
-                        }
-
-                        std::this_thread::yield();  // give a slot to other threads
+                    }
+                    if (!found && !times.empty()) {
+                        searchTimes();
                     }
                 }
             },
             blockHeight);
 
         if (!found) {
+            if (prepared) {
+                const auto &args = stakersArgs[std::get<0>(active.front())];
+                prepareBlock(chainparams,
+                             tip->GetBlockHash(),
+                             args.coinbaseScript,
+                             prepareTime,
+                             getEvmBeneficiary(args.minterKey));
+            }
             return Status::stakeWaiting;
         }
 
+        const auto mintedBlocks = std::get<1>(active[kernelIndex]);
+        auto stakeModifier = std::move(stakeModifiers[kernelIndex]);
+        minter = std::get<0>(active[kernelIndex]);
+        const auto &args = stakersArgs[minter];
+        const auto &scriptPubKey = args.coinbaseScript;
+        const auto evmBeneficiary = getEvmBeneficiary(args.minterKey);
+
         //
         // Create block template
         //
-        auto pubKey = args.minterKey.GetPubKey();
-        if (pubKey.IsCompressed()) {
-            pubKey.Decompress();
-        }
-        const auto evmBeneficiary = pubKey.GetEthID().GetHex();
-        auto res = BlockAssembler(chainparams).CreateNewBlock(scriptPubKey, blockTime, evmBeneficiary);
+        auto res = BlockAssembler(chainparams, prepared ? &prepared->txResults : nullptr)
+                       .CreateNewBlock(scriptPubKey, blockTime, evmBeneficiary);
         if (!res) {
             LogPrintf("Error: WalletStaker: %s\n", res.msg);
             return Status::stakeWaiting;
@@ -1466,40 +1601,38 @@ namespace pos {
                 continue;
             }
 
-            for (auto arg : *localStakersParams) {
-                if (ShutdownRequested()) {
-                    break;
-                }
-
-                const auto operatorName = arg.operatorID.GetHex();
+            if (!ShutdownRequested()) {
+                const auto &stakersArgs = *localStakersParams;
+                const auto operatorsName = strprintf("%d masternodes", stakersArgs.size());
 
-                pos::Staker staker;
+                pos::Staker staker{gArgs.GetBoolArg("-stakerprepare", DEFAULT_STAKER_PREPARE) ? &prepared : nullptr};
 
                 try {
+                    size_t minter{};
                     auto status = staker.init(chainparams);
                     if (status == Staker::Status::stakeReady) {
-                        status = staker.stake(chainparams, arg);
+                        status = staker.stake(chainparams, stakersArgs, minter);
                     }
                     if (status == Staker::Status::minted) {
-                        LogPrintf("ThreadStaker: (%s) minted a block!\n", operatorName);
+                        LogPrintf("ThreadStaker: (%s) minted a block!\n", stakersArgs[minter].operatorID.GetHex());
                         nPastFailures = 0;
                     } else if (status == Staker::Status::initWaiting) {
                         LogPrintCategoryOrThreadThrottled(BCLog::STAKING,
                                                           "init_waiting",
                                                           1000 * 60 * 10,
                                                           "ThreadStaker: (%s) waiting init...\n",
-                                                          operatorName);
+                                                          operatorsName);
                     } else if (status == Staker::Status::stakeWaiting) {
                         LogPrintCategoryOrThreadThrottled(BCLog::STAKING,
                                                           "no_kernel_found",
                                                           1000 * 60 * 10,
                                                           "ThreadStaker: (%s) Staked, but no kernel found yet.\n",
-                                                          operatorName);
+                                                          operatorsName);
                     }
                 } catch (const std::runtime_error &e) {
                     LogPrintf("ThreadStaker: (%s) runtime error: %s, nPastFailures: %d\n",
                               e.what(),
-                              operatorName,
+                              operatorsName,
                               nPastFailures);
 
                     if (!nPastFailures) {
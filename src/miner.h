@@ -7,6 +7,7 @@
 #define DEFI_MINER_H
 
 #include <dfi/res.h>
+#include <flushablestorage.h>
 #include <key.h>
 #include <primitives/block.h>
 #include <timedata.h>
@@ -22,6 +23,8 @@
 
 class BlockContext;
 class CBlockIndex;
+class CCoinsViewCache;
+class CCustomCSView;
 class CChainParams;
 class CScopedTemplate;
 class CScript;
@@ -35,6 +38,10 @@ namespace Consensus {
 static const bool DEFAULT_GENERATE = false;
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+static const bool DEFAULT_STAKER_PREPARE = false;
+static const int64_t STAKER_PREPARE_INTERVAL_MS = 5000;
+/** Number of times checked for all masternodes between two yields of the staker */
+static const size_t KERNEL_SEARCH_BATCH_SIZE = 16;
 
 extern TxOrderings txOrdering;
 
@@ -131,6 +138,30 @@ struct update_for_parent_inclusion {
     CTxMemPool::txiter iter;
 };
 
+// Results of the custom txs applied while assembling templates. The next
+// templates on the same tip take a result over as long as what the tx read
+// is unchanged, instead of applying the tx again. Owned by the staker and
+// only used by its thread, with cs_main held.
+class CTemplateTxResults {
+    struct Result {
+        CStorageKVReads reads;
+        std::vector<std::pair<TBytes, std::optional<TBytes>>> changes;
+        Res res{Res::Ok()};
+    };
+
+    static constexpr size_t MAX_RESULTS = 10000;
+
+    uint256 tip;
+    std::map<uint256, Result> results;
+
+public:
+    // Results of an earlier tip were applied at another height
+    void SetTip(const uint256 &hash);
+    // Same as ApplyCustomTx on the view, returns the result of the run
+    // that is taken over
+    Res Apply(BlockContext &blockCtx, CCustomCSView &view, const CCoinsViewCache &coins, const CTransaction &tx);
+};
+
 /** Generate a new block, without valid proof-of-work */
 class BlockAssembler {
 private:
@@ -156,6 +187,9 @@ private:
     int64_t nLockTimeCutoff;
     const CChainParams &chainparams;
 
+    // Results of custom txs applied by earlier templates, when reused
+    CTemplateTxResults *templateTxResults{};
+
 public:
     struct Options {
         Options();
@@ -165,6 +199,7 @@ public:
 
     explicit BlockAssembler(const CChainParams &params);
     BlockAssembler(const CChainParams &params, const Options &options);
+    BlockAssembler(const CChainParams &params, CTemplateTxResults *templateTxResults);
 
     /** Construct a new block template with coinbase to scriptPubKeyIn */
     ResVal<std::unique_ptr<CBlockTemplate>> CreateNewBlock(const CScript &scriptPubKeyIn,
@@ -233,6 +268,14 @@ namespace pos {
 
     extern AtomicMutex cs_MNLastBlockCreationAttemptTs;
 
+    // Templates assembled by a staker thread ahead of finding a kernel
+    struct PreparedTemplates {
+        CTemplateTxResults txResults;
+        uint256 tip;
+        unsigned int txsUpdated{};
+        int64_t time{};
+    };
+
     class ThreadStaker {
     public:
         struct Args {
@@ -246,13 +289,21 @@ namespace pos {
 
         /// always forward by value to avoid dangling pointers
         void operator()(CChainParams chainparams);
+
+    private:
+        PreparedTemplates prepared;
     };
 
     class Staker {
     private:
         static uint256 lastBlockSeen;
+        // Kept by the staker thread across its stakers, null when not prepared
+        PreparedTemplates *prepared{};
 
     public:
+        explicit Staker(PreparedTemplates *prepared = nullptr)
+            : prepared(prepared) {}
+
         enum class Status {
             initWaiting,
             stakeWaiting,
@@ -262,6 +313,11 @@ namespace pos {
 
         Staker::Status init(const CChainParams &chainparams);
         Staker::Status stake(const CChainParams &chainparams, const ThreadStaker::Args &args);
+        // Searches a kernel for all the args at once and mints with the first
+        // one found, minter is then set to its index in the args
+        Staker::Status stake(const CChainParams &chainparams,
+                             const std::vector<ThreadStaker::Args> &stakersArgs,
+                             size_t &minter);
 
         // declaration static variables
         // Map to store [master node id : last block creation attempt timestamp] for local master nodes
@@ -274,6 +330,14 @@ namespace pos {
     private:
         template <typename F>
         void withSearchInterval(F &&f, int64_t height);
+
+        // Assembles a template ahead of a kernel being found, so that
+        // the block for it reuses the custom txs applied meanwhile
+        void prepareBlock(const CChainParams &chainparams,
+                          const uint256 &tipHash,
+                          const CScript &scriptPubKey,
+                          const int64_t blockTime,
+                          const std::string &evmBeneficiary);
     };
 
     bool StartStakingThreads(std::vector<std::thread> &threadGroup);
@@ -8,13 +8,99 @@
 #include <logging.h>
 #include <dfi/masternodes.h>
 #include <dfi/mn_checks.h>
+#include <dfi/threadpool.h>
 #include <sync.h>
 #include <validation.h>
 
+#include <deque>
+#include <map>
+
 extern RecursiveMutex cs_main;
 
 namespace pos {
 
+// Headers are received ahead of their blocks and blocks are read back from
+// disk, keep the recovered keys around so that each signature is recovered once.
+// The block hash commits to every signed field and to the signature.
+class CRecoveredPubKeyCache {
+public:
+    std::optional<CPubKey> Get(const uint256& hash) {
+        LOCK(cs);
+        auto it = keys.find(hash);
+        if (it == keys.end()) {
+            return {};
+        }
+        return it->second;
+    }
+
+    void Insert(const std::vector<std::pair<uint256, CPubKey>>& entries) {
+        LOCK(cs);
+        for (const auto& [hash, pubKey] : entries) {
+            if (!keys.emplace(hash, pubKey).second) {
+                continue;
+            }
+            order.push_back(hash);
+            if (order.size() > RECOVERED_PUBKEY_CACHE_SIZE) {
+                keys.erase(order.front());
+                order.pop_front();
+            }
+        }
+    }
+
+private:
+    Mutex cs;
+    std::map<uint256, CPubKey> keys GUARDED_BY(cs);
+    std::deque<uint256> order GUARDED_BY(cs);
+};
+
+static CRecoveredPubKeyCache recoveredPubKeys;
+
+static bool RecoverHeaderPubKey(const CBlockHeader& blockHeader) {
+    if (blockHeader.GetRecoveredPubKey().IsValid()) {
+        return true;
+    }
+
+    const auto hash = blockHeader.GetHash();
+    if (auto pubKey = recoveredPubKeys.Get(hash)) {
+        blockHeader.SetRecoveredPubKey(*pubKey);
+        return true;
+    }
+
+    CKeyID key;
+    if (!blockHeader.ExtractMinterKey(key)) {
+        return false;
+    }
+    recoveredPubKeys.Insert({{hash, blockHeader.GetRecoveredPubKey()}});
+    return true;
+}
+
+void RecoverHeaderSignatures(const std::vector<CBlockHeader>& headers) {
+    std::vector<std::optional<std::pair<uint256, CPubKey>>> recovered(headers.size());
+
+    ParallelFor(headers.size(), HEADER_RECOVERY_BATCH_SIZE, [&](const size_t begin, const size_t end) {
+        CKeyID key;
+        for (auto i = begin; i < end; ++i) {
+            const auto& header = headers[i];
+            if (header.sig.empty() || header.GetRecoveredPubKey().IsValid()) {
+                continue;
+            }
+            // Failures are left to CheckHeaderSignature to report
+            if (header.ExtractMinterKey(key)) {
+                recovered[i].emplace(header.GetHash(), header.GetRecoveredPubKey());
+            }
+        }
+    });
+
+    std::vector<std::pair<uint256, CPubKey>> entries;
+    entries.reserve(headers.size());
+    for (auto& entry : recovered) {
+        if (entry) {
+            entries.push_back(std::move(*entry));
+        }
+    }
+    recoveredPubKeys.Insert(entries);
+}
+
 bool CheckStakeModifier(const CBlockIndex* pindexPrev, const CBlockHeader& blockHeader) {
     if (blockHeader.hashPrevBlock.IsNull())
         return blockHeader.stakeModifier.IsNull();
@@ -37,8 +123,7 @@ bool CheckHeaderSignature(const CBlockHeader& blockHeader) {
         return false;
     }
 
-    CPubKey recoveredPubKey{};
-    if (!recoveredPubKey.RecoverCompact(blockHeader.GetHashToSign(), blockHeader.sig)) {
+    if (!RecoverHeaderPubKey(blockHeader)) {
         LogPrintf("CheckBlockSignature: Bad Block - malformed signature\n");
         return false;
     }
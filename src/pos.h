@@ -4,6 +4,7 @@
 #include <consensus/params.h>
 #include <arith_uint256.h>
 #include <memory>
+#include <vector>
 #include <key.h>
 
 class CBlock;
@@ -18,6 +19,9 @@ class CCoinsViewCache;
 
 class CCustomCSView;
 
+static const size_t HEADER_RECOVERY_BATCH_SIZE = 64;
+static const size_t RECOVERED_PUBKEY_CACHE_SIZE = 16384;
+
 /// A state that's passed along between various 
 /// Check functions like CheckBlocks, ContextualCheckProofOfStake,
 /// CheckKernelHash, etc to maintain context across the
@@ -34,6 +38,9 @@ namespace pos {
 /// Check PoS signatures (PoS block hashes are signed with privkey of  first coinstake out pubkey)
     bool CheckHeaderSignature(const CBlockHeader& block);
 
+/// Recover the signing keys of a batch of headers in parallel ahead of CheckHeaderSignature
+    void RecoverHeaderSignatures(const std::vector<CBlockHeader>& headers);
+
 /// Check kernel hash target and coinstake signature
     bool ContextualCheckProofOfStake(const CBlockHeader& blockHeader, const Consensus::Params& params, CCustomCSView* mnView, CheckContextState& ctxState, const int height);
 
@@ -1,6 +1,8 @@
 #include <pos_kernel.h>
 #include <amount.h>
 #include <arith_uint256.h>
+#include <crypto/common.h>
+#include <crypto/sha256.h>
 #include <key.h>
 #include <validation.h>
 
@@ -9,6 +11,9 @@
 extern CAmount GetMnCollateralAmount(int); // from masternodes.h
 
 namespace pos {
+    // Stake age that adds one to the coinDayWeight
+    static const constexpr uint32_t COIN_DAY_WEIGHT_PERIOD = 6 * 60 * 60; // 6 hours
+
     uint256 CalcKernelHash(const uint256& stakeModifier, int64_t height, int64_t coinstakeTime, const uint256& masternodeID) {
         // Calculate hash
         CDataStream ss(SER_GETHASH, 0);
@@ -32,9 +37,17 @@ namespace pos {
         nTimeTx = std::max(nTimeTx, params.pos.nStakeMinAge);
 
         // Calculate coinDayWeight, at min this is 1 with no impact on difficulty.
-        static const constexpr uint32_t period = 6 * 60 * 60; // 6 hours
+        return (arith_uint256(nTimeTx) + COIN_DAY_WEIGHT_PERIOD) / COIN_DAY_WEIGHT_PERIOD;
+    }
 
-        return (arith_uint256(nTimeTx) + period) / period;
+    // Same as CalcCoinDayWeight without a 256 bit division for the usual ages
+    static arith_uint256 CalcCoinDayWeightFast(const Consensus::Params& params, const int64_t coinstakeTime, const int64_t stakersBlockTime)
+    {
+        const auto nTimeTx = std::max(std::min(coinstakeTime - stakersBlockTime, params.pos.nStakeMaxAge), params.pos.nStakeMinAge);
+        if (nTimeTx < 0) {
+            return CalcCoinDayWeight(params, coinstakeTime, stakersBlockTime);
+        }
+        return arith_uint256((nTimeTx + COIN_DAY_WEIGHT_PERIOD) / COIN_DAY_WEIGHT_PERIOD);
     }
 
     bool CheckKernelHash(const uint256& stakeModifier, uint32_t nBits, int64_t creationHeight, int64_t coinstakeTime, uint64_t blockHeight,
@@ -72,6 +85,77 @@ namespace pos {
         return (hashProofOfStake / static_cast<uint64_t>( GetMnCollateralAmount( static_cast<int>(creationHeight) ) ) ) <= targetProofOfStake;
     }
 
+    CKernelSearch::CKernelSearch(uint32_t nBits, uint64_t blockHeight, const Consensus::Params& params)
+        : params(params), blockHeight(blockHeight) {
+        targetProofOfStake.SetCompact(nBits);
+    }
+
+    void CKernelSearch::AddCandidate(const KernelCandidate& candidate) {
+        // Same layout as the stream of CalcKernelHashMulti, time left at zero
+        std::array<unsigned char, 81> kernel{};
+        std::copy(candidate.stakeModifier.begin(), candidate.stakeModifier.end(), kernel.begin());
+        const auto collateral = GetMnCollateralAmount(static_cast<int>(candidate.creationHeight));
+        WriteLE64(&kernel[40], static_cast<uint64_t>(collateral));
+        std::copy(candidate.masternodeID.begin(), candidate.masternodeID.end(), kernel.begin() + 48);
+
+        const Member member{size++, candidate.subNodeBlockTime, candidate.subNode};
+        for (auto& group : groups) {
+            if (group.kernel == kernel) {
+                group.members.push_back(member);
+                return;
+            }
+        }
+
+        Group group{kernel, arith_uint256(static_cast<uint64_t>(collateral)), {}, {member}};
+        group.limit = ~arith_uint256() / group.collateral;
+        groups.push_back(std::move(group));
+    }
+
+    std::optional<std::pair<int64_t, size_t>> CKernelSearch::Search(const std::vector<int64_t>& times) const {
+        const auto multi = blockHeight >= static_cast<uint64_t>(params.DF10EunosPayaHeight);
+        const auto weighted = blockHeight >= static_cast<uint64_t>(params.DF7DakotaCrescentHeight);
+        const size_t kernelSize = multi ? 81 : 80;
+
+        for (const auto time : times) {
+            std::optional<size_t> found;
+            for (const auto& group : groups) {
+                auto kernel = group.kernel;
+                WriteLE64(&kernel[32], static_cast<uint64_t>(time));
+
+                // Stake modifier, time, collateral and the start of the masternode ID
+                CSHA256 first;
+                first.Write(kernel.data(), 64);
+
+                for (const auto& member : group.members) {
+                    if (found && *found < member.index) {
+                        break;
+                    }
+                    kernel[80] = member.subNode;
+
+                    uint256 hash;
+                    CSHA256(first).Write(&kernel[64], kernelSize - 64).Finalize(hash.begin());
+                    CSHA256().Write(hash.begin(), CSHA256::OUTPUT_SIZE).Finalize(hash.begin());
+
+                    auto target = targetProofOfStake;
+                    if (weighted) {
+                        target = target * CalcCoinDayWeightFast(params, time, member.subNodeBlockTime);
+                    }
+
+                    // hash / collateral <= target is hash < (target + 1) * collateral,
+                    // which holds for any hash once the product overflows.
+                    if (target >= group.limit || UintToArith256(hash) < (target + 1) * group.collateral) {
+                        found = member.index;
+                    }
+                }
+            }
+            if (found) {
+                return std::make_pair(time, *found);
+            }
+        }
+
+        return {};
+    }
+
     uint256 ComputeStakeModifier(const uint256& prevStakeModifier, const CKeyID& key) {
         // Calculate hash
         CDataStream ss(SER_GETHASH, 0);
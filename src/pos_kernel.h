@@ -8,6 +8,10 @@
 #include <amount.h>
 #include <pos.h>
 
+#include <array>
+#include <optional>
+#include <vector>
+
 class CWallet;
 class COutPoint;
 class CBlock;
@@ -30,6 +34,51 @@ namespace pos {
     bool CheckKernelHash(const uint256& stakeModifier, uint32_t nBits, int64_t creationHeight, int64_t coinstakeTime, uint64_t blockHeight,
                          const uint256& masternodeID, const Consensus::Params& params, const int64_t subNodeBlockTime, const CheckContextState ctxState);
 
+/// Masternode and subnode checked by a kernel search
+    struct KernelCandidate {
+        uint256 stakeModifier;
+        int64_t creationHeight{};
+        uint256 masternodeID;
+        int64_t subNodeBlockTime{};
+        uint8_t subNode{};
+    };
+
+/// Checks many candidates over many times, with the same results as CheckKernelHash.
+/// Subnodes of a masternode share the first block of their kernel hash and
+/// the target is compared without dividing the hash by the collateral.
+    class CKernelSearch {
+    public:
+        CKernelSearch(uint32_t nBits, uint64_t blockHeight, const Consensus::Params& params);
+
+        void AddCandidate(const KernelCandidate& candidate);
+        size_t Size() const { return size; }
+
+        /// First time in the given order that meets the target with any candidate,
+        /// returned with the lowest index of the candidates that meet it
+        std::optional<std::pair<int64_t, size_t>> Search(const std::vector<int64_t>& times) const;
+
+    private:
+        struct Member {
+            size_t index;
+            int64_t subNodeBlockTime;
+            uint8_t subNode;
+        };
+        struct Group {
+            // Serialized kernel, the time at offset 32 is set for each time searched
+            std::array<unsigned char, 81> kernel;
+            arith_uint256 collateral;
+            // Largest target for which (target + 1) * collateral does not overflow
+            arith_uint256 limit;
+            std::vector<Member> members;
+        };
+
+        const Consensus::Params& params;
+        const uint64_t blockHeight;
+        arith_uint256 targetProofOfStake;
+        std::vector<Group> groups;
+        size_t size{};
+    };
+
 /// Stake Modifier (hash modifier of proof-of-stake)
     uint256 ComputeStakeModifier(const uint256& prevStakeModifier, const CKeyID& key);
 }
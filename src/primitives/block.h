@@ -95,6 +95,18 @@ public:
         key = recoveredPubKey.GetID();
         return true;
     }
+
+    // Key recovered from the signature, invalid until ExtractMinterKey succeeds
+    const CPubKey& GetRecoveredPubKey() const
+    {
+        return recoveredPubKey;
+    }
+
+    // Seeds the memo with the key already recovered for an identical header
+    void SetRecoveredPubKey(const CPubKey &pubKey) const
+    {
+        recoveredPubKey = pubKey;
+    }
 };
 
 
@@ -25,6 +25,7 @@
 #include <policy/policy.h>
 #include <policy/rbf.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonstream.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <rpc/resultcache.h>
@@ -352,7 +353,7 @@ UniValue ExtendedTxToUniv(CCustomCSView &view, const CTransaction& tx, bool incl
     }
 }
 
-UniValue blockToJSON(CCustomCSView &view, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails, int version)
+static UniValue blockToJSONImpl(CCustomCSView &view, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails, int version, CJSONStreamWriter* stream)
 {
     // Serialize passed information without accessing chain state of the active chain!
     AssertLockNotHeld(cs_main); // For performance reasons
@@ -361,6 +362,10 @@ UniValue blockToJSON(CCustomCSView &view, const CBlock& block, const CBlockIndex
 
     auto txsToUniValue = [&](const CBlock& block, bool txDetails, int version) {
         UniValue txs(UniValue::VARR);
+        // Streamed in place of the empty array
+        if (stream) {
+            return txs;
+        }
         for(const auto& tx : block.vtx) {
             txs.push_back(ExtendedTxToUniv(view, *tx, txDetails, RPCSerializationFlags(), version, txDetails, isEvmEnabledForBlock));
         }
@@ -416,9 +421,40 @@ UniValue blockToJSON(CCustomCSView &view, const CBlock& block, const CBlockIndex
         result.pushKV("tx", txsToUniValue(block, txDetails, version));
     }
 
+    if (stream) {
+        // Only one transaction is held as UniValue at a time
+        const auto &keys = result.getKeys();
+        const auto &values = result.getValues();
+        stream->BeginObject();
+        for (size_t i = 0; i < keys.size(); ++i) {
+            stream->Key(keys[i]);
+            if (keys[i] != "tx") {
+                stream->Value(values[i]);
+                continue;
+            }
+            stream->BeginArray();
+            for (const auto& tx : block.vtx) {
+                stream->Value(ExtendedTxToUniv(view, *tx, txDetails, RPCSerializationFlags(), version, txDetails, isEvmEnabledForBlock));
+            }
+            stream->EndArray();
+        }
+        stream->EndObject();
+        return NullUniValue;
+    }
+
     return result;
 }
 
+UniValue blockToJSON(CCustomCSView &view, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails, int version)
+{
+    return blockToJSONImpl(view, block, tip, blockindex, txDetails, version, nullptr);
+}
+
+void blockToJSON(CJSONStreamWriter &stream, CCustomCSView &view, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails, int version)
+{
+    blockToJSONImpl(view, block, tip, blockindex, txDetails, version, &stream);
+}
+
 static UniValue getblockcount(const JSONRPCRequest& request)
 {
             RPCHelpMan{"getblockcount",
@@ -1172,6 +1208,11 @@ static UniValue getblock(const JSONRPCRequest& request)
     }
 
     auto [view, accountView, vaultView] = GetSnapshots();
+    // Blocks with transaction details can be large, write them as they are produced
+    if (request.resultStream && verbosity >= 2) {
+        blockToJSON(*request.resultStream, *view, block, tip, pblockindex, true, verbosity);
+        return NullUniValue;
+    }
     return blockToJSON(*view, block, tip, pblockindex, verbosity >= 2, verbosity);
 }
 
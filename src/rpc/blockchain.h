@@ -16,6 +16,7 @@ extern RecursiveMutex cs_main;
 class CBlock;
 class CBlockIndex;
 class CCustomCSView;
+class CJSONStreamWriter;
 class CTxMemPool;
 class UniValue;
 class CTransaction;
@@ -38,6 +39,8 @@ UniValue ExtendedTxToUniv(CCustomCSView &view, const CTransaction& tx, bool incl
 
 /** Block description to JSON */
 UniValue blockToJSON(CCustomCSView &view, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails = false, int verbosity = 0) LOCKS_EXCLUDED(cs_main);
+/** Block description written to the stream, one transaction at a time */
+void blockToJSON(CJSONStreamWriter &stream, CCustomCSView &view, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails, int verbosity) LOCKS_EXCLUDED(cs_main);
 
 /** Mempool information to JSON */
 UniValue MempoolInfoToJSON(const CTxMemPool& pool);
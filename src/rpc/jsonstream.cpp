@@ -0,0 +1,217 @@
+#include <rpc/jsonstream.h>
+
+#include <array>
+#include <cassert>
+#include <charconv>
+
+// Same escapes as UniValue::write
+static std::array<const char *, 256> GetEscapes() {
+    static const char *const controls[0x20] = {
+        "\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005", "\\u0006", "\\u0007",
+        "\\b",     "\\t",     "\\n",     "\\u000b", "\\f",     "\\r",     "\\u000e", "\\u000f",
+        "\\u0010", "\\u0011", "\\u0012", "\\u0013", "\\u0014", "\\u0015", "\\u0016", "\\u0017",
+        "\\u0018", "\\u0019", "\\u001a", "\\u001b", "\\u001c", "\\u001d", "\\u001e", "\\u001f",
+    };
+    std::array<const char *, 256> escapes{};
+    for (size_t i = 0; i < 0x20; ++i) {
+        escapes[i] = controls[i];
+    }
+    escapes['"'] = "\\\"";
+    escapes['\\'] = "\\\\";
+    escapes[0x7f] = "\\u007f";
+    return escapes;
+}
+
+static const std::array<const char *, 256> jsonEscapes = GetEscapes();
+
+CJSONStreamWriter::CJSONStreamWriter(Sink sink, const size_t chunkSize)
+    : sink(std::move(sink)),
+      chunkSize(chunkSize) {
+    buffer.reserve(chunkSize + chunkSize / 4);
+}
+
+void CJSONStreamWriter::Separator() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (!hasMembers.empty()) {
+        if (hasMembers.back()) {
+            buffer += ',';
+        }
+        hasMembers.back() = true;
+    }
+}
+
+void CJSONStreamWriter::Capture() {
+    if (capturing) {
+        captured.append(buffer, captureFrom);
+        captureFrom = 0;
+    }
+}
+
+void CJSONStreamWriter::MaybeFlush() {
+    if (buffer.size() >= chunkSize) {
+        Flush();
+    }
+}
+
+void CJSONStreamWriter::WriteString(std::string_view str) {
+    buffer += '"';
+    // Copies the runs without escapes in one go
+    size_t begin{};
+    for (size_t i = 0; i < str.size(); ++i) {
+        if (const auto escape = jsonEscapes[static_cast<unsigned char>(str[i])]) {
+            buffer.append(str.data() + begin, i - begin);
+            buffer += escape;
+            begin = i + 1;
+        }
+    }
+    buffer.append(str.data() + begin, str.size() - begin);
+    buffer += '"';
+}
+
+void CJSONStreamWriter::BeginObject() {
+    Separator();
+    buffer += '{';
+    hasMembers.push_back(false);
+}
+
+void CJSONStreamWriter::EndObject() {
+    assert(!hasMembers.empty() && !afterKey);
+    hasMembers.pop_back();
+    buffer += '}';
+    MaybeFlush();
+}
+
+void CJSONStreamWriter::BeginArray() {
+    Separator();
+    buffer += '[';
+    hasMembers.push_back(false);
+}
+
+void CJSONStreamWriter::EndArray() {
+    assert(!hasMembers.empty() && !afterKey);
+    hasMembers.pop_back();
+    buffer += ']';
+    MaybeFlush();
+}
+
+void CJSONStreamWriter::Key(std::string_view key) {
+    assert(!hasMembers.empty() && !afterKey);
+    Separator();
+    WriteString(key);
+    buffer += ':';
+    afterKey = true;
+}
+
+void CJSONStreamWriter::Null() {
+    Separator();
+    buffer += "null";
+    MaybeFlush();
+}
+
+void CJSONStreamWriter::Value(const bool value) {
+    Separator();
+    buffer += value ? "true" : "false";
+    MaybeFlush();
+}
+
+void CJSONStreamWriter::Value(const int64_t value) {
+    Separator();
+    char str[24];
+    const auto res = std::to_chars(str, str + sizeof(str), value);
+    buffer.append(str, res.ptr);
+    MaybeFlush();
+}
+
+void CJSONStreamWriter::Value(const uint64_t value) {
+    Separator();
+    char str[24];
+    const auto res = std::to_chars(str, str + sizeof(str), value);
+    buffer.append(str, res.ptr);
+    MaybeFlush();
+}
+
+void CJSONStreamWriter::Value(std::string_view value) {
+    Separator();
+    WriteString(value);
+    MaybeFlush();
+}
+
+void CJSONStreamWriter::Value(const UniValue &value) {
+    switch (value.getType()) {
+        case UniValue::VNULL:
+            Null();
+            break;
+        case UniValue::VOBJ: {
+            BeginObject();
+            const auto &keys = value.getKeys();
+            const auto &values = value.getValues();
+            for (size_t i = 0; i < keys.size(); ++i) {
+                Key(keys[i]);
+                Value(values[i]);
+            }
+            EndObject();
+            break;
+        }
+        case UniValue::VARR:
+            BeginArray();
+            for (const auto &item : value.getValues()) {
+                Value(item);
+            }
+            EndArray();
+            break;
+        case UniValue::VSTR:
+            Value(std::string_view{value.getValStr()});
+            break;
+        case UniValue::VNUM:
+            // Numbers are kept in their serialized form
+            Separator();
+            buffer += value.getValStr();
+            MaybeFlush();
+            break;
+        case UniValue::VBOOL:
+            Value(value.get_bool());
+            break;
+    }
+}
+
+void CJSONStreamWriter::Raw(std::string_view json) {
+    Separator();
+    buffer.append(json);
+    MaybeFlush();
+}
+
+void CJSONStreamWriter::Flush() {
+    if (buffer.empty()) {
+        return;
+    }
+    Capture();
+    written += buffer.size();
+    flushed = true;
+    std::string chunk;
+    chunk.reserve(chunkSize + chunkSize / 4);
+    chunk.swap(buffer);
+    sink(std::move(chunk));
+}
+
+std::string CJSONStreamWriter::Release() {
+    Capture();
+    std::string out;
+    out.swap(buffer);
+    written += out.size();
+    return out;
+}
+
+void CJSONStreamWriter::StartCapture() {
+    capturing = true;
+    captureFrom = buffer.size();
+    captured.clear();
+}
+
+std::string CJSONStreamWriter::EndCapture() {
+    Capture();
+    capturing = false;
+    return std::move(captured);
+}
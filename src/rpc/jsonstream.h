@@ -0,0 +1,78 @@
+#ifndef DEFI_RPC_JSONSTREAM_H
+#define DEFI_RPC_JSONSTREAM_H
+
+#include <univalue.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static const size_t JSON_STREAM_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Writes JSON incrementally, in the compact layout of UniValue::write, and
+ * hands the output to the sink in chunks of about chunkSize bytes. Lets RPC
+ * results be sent while they are produced instead of building the whole
+ * UniValue tree and its serialized string first.
+ */
+class CJSONStreamWriter {
+public:
+    using Sink = std::function<void(std::string &&chunk)>;
+
+    explicit CJSONStreamWriter(Sink sink, size_t chunkSize = JSON_STREAM_CHUNK_SIZE);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    void Key(std::string_view key);
+
+    void Null();
+    void Value(bool value);
+    void Value(int value) { Value(static_cast<int64_t>(value)); }
+    void Value(int64_t value);
+    void Value(uint64_t value);
+    void Value(const char *value) { Value(std::string_view{value}); }
+    void Value(const std::string &value) { Value(std::string_view{value}); }
+    void Value(std::string_view value);
+    void Value(const UniValue &value);
+    // Already serialized JSON, written as is
+    void Raw(std::string_view json);
+
+    // Hands the buffered output to the sink
+    void Flush();
+    // True once any output went to the sink
+    bool Flushed() const { return flushed; }
+    // Takes the output not handed to the sink yet
+    std::string Release();
+    // Bytes written so far, flushed or not
+    size_t Size() const { return written + buffer.size(); }
+    // Keeps a copy of the output written from now on, e.g. for the result cache
+    void StartCapture();
+    // Stops copying and returns the copy
+    std::string EndCapture();
+
+private:
+    void Separator();
+    void WriteString(std::string_view str);
+    void MaybeFlush();
+    // Copies the buffered output to the capture
+    void Capture();
+
+    Sink sink;
+    size_t chunkSize;
+    std::string buffer;
+    size_t written{};
+    bool flushed{};
+    bool capturing{};
+    // Start of the captured output in the buffer
+    size_t captureFrom{};
+    std::string captured;
+    // Per open object or array, whether it has a member already
+    std::vector<bool> hasMembers;
+    bool afterKey{};
+};
+
+#endif  // DEFI_RPC_JSONSTREAM_H
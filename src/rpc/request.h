@@ -11,6 +11,8 @@
 #include <dfi/coinselect.h>
 #include <util/system.h>
 
+class CJSONStreamWriter;
+
 UniValue JSONRPCRequestObj(const std::string& strMethod, const UniValue& params, const UniValue& id);
 UniValue JSONRPCReplyObj(const UniValue& result, const UniValue& error, const UniValue& id);
 std::string JSONRPCReply(const UniValue& result, const UniValue& error, const UniValue& id);
@@ -70,6 +72,8 @@ public:
     std::string authUser;
     std::string peerAddr;
     RPCMetadata metadata;
+    /** When set, a handler may write its result here instead of returning it */
+    CJSONStreamWriter* resultStream{nullptr};
 
     JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false), metadata(RPCMetadata::CreateDefault()) {}
     void parse(const UniValue& valRequest);
@@ -2,9 +2,78 @@
 #include <rpc/util.h>
 #include <logging.h>
 #include <validation.h>
+#include <dfi/accounts.h>
+#include <dfi/gv.h>
+#include <dfi/loan.h>
+#include <dfi/oracles.h>
+#include <dfi/poolpairs.h>
+#include <dfi/tokens.h>
+
+// Methods whose results only depend on the listed state. Results depending
+// on the height, the block time, or the UTXO set are left to the per block
+// invalidation.
+static const std::map<std::string, uint32_t> methodDeps{
+    {"getpoolpair", RPCCacheDeps::Pools | RPCCacheDeps::Tokens | RPCCacheDeps::Accounts | RPCCacheDeps::Gov},
+    {"listpoolpairs", RPCCacheDeps::Pools | RPCCacheDeps::Tokens | RPCCacheDeps::Accounts | RPCCacheDeps::Gov},
+    {"getoracledata", RPCCacheDeps::Oracles},
+    {"listoracles", RPCCacheDeps::Oracles},
+    {"getgov", RPCCacheDeps::Gov | RPCCacheDeps::Tokens},
+    {"getloanscheme", RPCCacheDeps::LoanSchemes},
+    {"listloanschemes", RPCCacheDeps::LoanSchemes},
+};
+
+static std::array<uint32_t, 256> GetPrefixDeps() {
+    std::array<uint32_t, 256> deps{};
+    for (auto prefix : {CTokensView::ID::prefix(), CTokensView::Symbol::prefix(), CTokensView::CreationTx::prefix(),
+                        CTokensView::LastDctId::prefix(), CTokensView::TokenSplitMultiplier::prefix(),
+                        CTokensView::NewTokenCollateralTXID::prefix(), CTokensView::NewTokenCollateralID::prefix()}) {
+        deps[prefix] |= RPCCacheDeps::Tokens;
+    }
+    for (auto prefix : {CPoolPairView::ByID::prefix(), CPoolPairView::ByPair::prefix(), CPoolPairView::ByShare::prefix(),
+                        CPoolPairView::ByIDPair::prefix(), CPoolPairView::ByPoolSwap::prefix(),
+                        CPoolPairView::ByReserves::prefix(), CPoolPairView::ByRewardPct::prefix(),
+                        CPoolPairView::ByPoolReward::prefix(), CPoolPairView::ByDailyReward::prefix(),
+                        CPoolPairView::ByCustomReward::prefix(), CPoolPairView::ByTotalLiquidity::prefix(),
+                        CPoolPairView::ByDailyLoanReward::prefix(), CPoolPairView::ByRewardLoanPct::prefix(),
+                        CPoolPairView::ByPoolLoanReward::prefix(), CPoolPairView::ByTokenDexFeePct::prefix(),
+                        CPoolPairView::ByLoanTokenLiquidityPerBlock::prefix(),
+                        CPoolPairView::ByLoanTokenLiquidityAverage::prefix(),
+                        CPoolPairView::ByTotalRewardPerShare::prefix(),
+                        CPoolPairView::ByTotalLoanRewardPerShare::prefix(),
+                        CPoolPairView::ByTotalCustomRewardPerShare::prefix(),
+                        CPoolPairView::ByTotalCommissionPerShare::prefix(), CPoolPairView::ByOwnerShare::prefix()}) {
+        deps[prefix] |= RPCCacheDeps::Pools;
+    }
+    for (auto prefix : {CAccountsView::ByBalanceKey::prefix(), CAccountsView::ByHeightKey::prefix(),
+                        CAccountsView::ByFuturesSwapKey::prefix(), CAccountsView::ByFuturesDUSDKey::prefix(),
+                        CAccountsView::ByTokenLockKey::prefix()}) {
+        deps[prefix] |= RPCCacheDeps::Accounts;
+    }
+    for (auto prefix : {COracleView::ByName::prefix(), COracleView::PriceDeviation::prefix(),
+                        COracleView::FixedIntervalBlockKey::prefix(), COracleView::FixedIntervalPriceKey::prefix(),
+                        COracleView::ByPriceFeed::prefix()}) {
+        deps[prefix] |= RPCCacheDeps::Oracles;
+    }
+    for (auto prefix : {CGovView::ByHeightVars::prefix(), CGovView::ByName::prefix(),
+                        CGovView::ByUnsetHeightVars::prefix(), CGovView::ByAttribute::prefix()}) {
+        deps[prefix] |= RPCCacheDeps::Gov;
+    }
+    for (auto prefix : {CLoanView::LoanSchemeKey::prefix(), CLoanView::DefaultLoanSchemeKey::prefix(),
+                        CLoanView::DelayedLoanSchemeKey::prefix(), CLoanView::DestroyLoanSchemeKey::prefix()}) {
+        deps[prefix] |= RPCCacheDeps::LoanSchemes;
+    }
+    return deps;
+}
+
+uint32_t GetRPCCacheDeps(uint8_t prefix) {
+    static const auto prefixDeps = GetPrefixDeps();
+    return prefixDeps[prefix];
+}
+
+// Epoch seen by the request this thread is executing
+static thread_local uint64_t requestEpoch{};
 
 void RPCResultCache::Init(RPCCacheMode mode) {
-    std::unique_lock l{aMutex};
     this->mode = mode;
 }
 
@@ -14,47 +83,102 @@ std::string GetKey(const JSONRPCRequest &request) {
     return ss.str();
 }
 
-bool RPCResultCache::InvalidateCaches() {
-    std::unique_lock l{aMutex};
-    auto height = GetLastValidatedHeight();
-    if (cacheHeight != height) {
-        LogPrint(BCLog::RPCCACHE, "RPCCache: clear\n");
-        if (cacheMap.size()) cacheMap.clear();
-        cacheHeight = height;
-        return true;
+bool RPCResultCache::IsCached(const std::string &method) const {
+    auto cacheMode = mode.load();
+    if (cacheMode == RPCCacheMode::None) return false;
+    if (cacheMode == RPCCacheMode::Smart &&
+        smartModeList.find(method) == smartModeList.end()) return false;
+    return true;
+}
+
+RPCResultCache::Shard& RPCResultCache::GetShard(const std::string &key) {
+    return shards[std::hash<std::string>{}(key) % SHARDS];
+}
+
+bool RPCResultCache::InvalidateCaches(uint32_t changedDeps) {
+    ++epoch;
+    size_t erased{};
+    for (auto &shard : shards) {
+        std::unique_lock l{shard.aMutex};
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            if (it->second->deps & changedDeps) {
+                it = shard.entries.erase(it);
+                ++erased;
+            } else {
+                ++it;
+            }
+        }
     }
-    return false;
+    LogPrint(BCLog::RPCCACHE, "RPCCache: invalidate: deps: %x, erased: %d\n", changedDeps, erased);
+    return erased > 0;
 }
 
-std::optional<UniValue> RPCResultCache::TryGet(const JSONRPCRequest &request) {
-    auto cacheMode = mode;
-    if (cacheMode == RPCCacheMode::None) return {};
-    if (cacheMode == RPCCacheMode::Smart &&
-        smartModeList.find(request.strMethod) == smartModeList.end()) return {};
+std::shared_ptr<const RPCResultCache::Entry> RPCResultCache::Find(const JSONRPCRequest &request) {
+    if (!IsCached(request.strMethod)) return {};
+    requestEpoch = epoch.load();
     auto key = GetKey(request);
-    UniValue val;
+    std::shared_ptr<const Entry> entry;
     {
-        std::unique_lock l{aMutex};
-        if (auto res = cacheMap.find(key); res != cacheMap.end()) {
-            if (LogAcceptCategory(BCLog::RPCCACHE)) {
-                LogPrint(BCLog::RPCCACHE, "RPCCache: hit: key: %d/%s, val: %s\n", cacheHeight, key, res->second.write());
-            }
-            return res->second;
+        auto &shard = GetShard(key);
+        std::unique_lock l{shard.aMutex};
+        if (auto res = shard.entries.find(key); res != shard.entries.end()) {
+            entry = res->second;
+        }
+    }
+    if (entry && LogAcceptCategory(BCLog::RPCCACHE)) {
+        LogPrint(BCLog::RPCCACHE, "RPCCache: hit: key: %d/%s, val: %s\n", GetLastValidatedHeight(), key, entry->json);
+    }
+    return entry;
+}
+
+std::optional<UniValue> RPCResultCache::TryGet(const JSONRPCRequest &request) {
+    if (auto entry = Find(request)) {
+        // Streamed results are kept in their serialized form only
+        if (entry->value.isNull() && entry->json != "null") {
+            UniValue value;
+            value.read(entry->json);
+            return value;
         }
+        return entry->value;
+    }
+    return {};
+}
+
+std::shared_ptr<const std::string> RPCResultCache::TryGetJSON(const JSONRPCRequest &request) {
+    if (auto entry = Find(request)) {
+        return {entry, &entry->json};
     }
     return {};
 }
 
 const UniValue& RPCResultCache::Set(const JSONRPCRequest &request, const UniValue &value) {
+    if (!IsCached(request.strMethod)) return value;
+    Store(request, value, value.write());
+    return value;
+}
+
+void RPCResultCache::SetJSON(const JSONRPCRequest &request, std::string json) {
+    if (!IsCached(request.strMethod)) return;
+    Store(request, NullUniValue, std::move(json));
+}
+
+void RPCResultCache::Store(const JSONRPCRequest &request, UniValue value, std::string json) {
     auto key = GetKey(request);
-    {
-        std::unique_lock l{aMutex};
-        if (LogAcceptCategory(BCLog::RPCCACHE)) {
-            LogPrint(BCLog::RPCCACHE, "RPCCache: set: key: %d/%s, val: %s\n", cacheHeight, key, value.write());
-        }
-        cacheMap[key] = value;
+    auto deps = RPCCacheDeps::Block;
+    if (auto it = methodDeps.find(request.strMethod); it != methodDeps.end()) {
+        deps = it->second;
     }
-    return value;
+    auto entry = std::make_shared<const Entry>(Entry{std::move(value), std::move(json), deps});
+    auto &shard = GetShard(key);
+    std::unique_lock l{shard.aMutex};
+    // The state the result was built from may already be gone
+    if (epoch.load() != requestEpoch) {
+        return;
+    }
+    if (LogAcceptCategory(BCLog::RPCCACHE)) {
+        LogPrint(BCLog::RPCCACHE, "RPCCache: set: key: %d/%s, val: %s\n", GetLastValidatedHeight(), key, entry->json);
+    }
+    shard.entries[key] = std::move(entry);
 }
 
 // Note: We initialize all the globals in the init phase. So, it's safe. Otherwise,
@@ -64,57 +188,46 @@ RPCResultCache& GetRPCResultCache() {
     return g_rpcResultCache;
 }
 
-static std::atomic<int> g_lastValidatedHeight{0};
-
-int GetLastValidatedHeight() {
-    auto res = g_lastValidatedHeight.load(std::memory_order_acquire);
-    return res;
-}
-
-void SetLastValidatedHeight(int height) {
-    LogPrint(BCLog::RPCCACHE, "RPCCache: set height: %d\n", height);
-    g_lastValidatedHeight.store(height, std::memory_order_release);
-    GetRPCResultCache().InvalidateCaches();
+RPCResultArray::RPCResultArray(const JSONRPCRequest &request)
+    : request(request),
+      stream(request.resultStream) {
+    if (stream) {
+        cached = GetRPCResultCache().IsCached(request.strMethod);
+        if (cached) {
+            stream->StartCapture();
+        }
+        stream->BeginArray();
+    }
 }
 
-void MemoizedResultCache::Init(RPCResultCache::RPCCacheMode mode) {
-    std::unique_lock l{aMutex};
-    this->mode = mode;
+void RPCResultArray::push_back(const UniValue &item) {
+    if (stream) {
+        stream->Value(item);
+    } else {
+        array.push_back(item);
+    }
 }
 
-CMemoizedResultValue MemoizedResultCache::GetOrDefault(const JSONRPCRequest &request) {
-    if (mode == RPCResultCache::RPCCacheMode::None) return {};
-    auto key = GetKey(request);
-    {
-        std::unique_lock l{aMutex};
-        if (auto res = cacheMap.find(key); res != cacheMap.end()) {
-            auto val = res->second;
-            if (!::ChainActive().Contains(LookupBlockIndex(val.hash)))
-                return {};
-
-            if (LogAcceptCategory(BCLog::RPCCACHE)) {
-                LogPrint(BCLog::RPCCACHE, "RPCCache: hit: key: %d/%s\n", val.height, key);
-            }
-            return val;
-        }
+UniValue RPCResultArray::Finish() {
+    if (!stream) {
+        return GetRPCResultCache().Set(request, array);
     }
-    return {};
+    stream->EndArray();
+    if (cached) {
+        GetRPCResultCache().SetJSON(request, stream->EndCapture());
+    }
+    return NullUniValue;
 }
 
-void MemoizedResultCache::Set(const JSONRPCRequest &request, const CMemoizedResultValue &value) {
-    auto key = GetKey(request);
-    {
-        std::unique_lock l{aMutex};
-        if (LogAcceptCategory(BCLog::RPCCACHE)) {
-            LogPrint(BCLog::RPCCACHE, "RPCCache: set: key: %d/%s\n", value.height, key);
-        }
-        cacheMap[key] = value;
-    }
+static std::atomic<int> g_lastValidatedHeight{0};
+
+int GetLastValidatedHeight() {
+    auto res = g_lastValidatedHeight.load(std::memory_order_acquire);
+    return res;
 }
 
-// Note: We initialize all the globals in the init phase. So, it's safe. Otherwise,
-// static init is undefined behavior when multiple threads init them at the same time.
-MemoizedResultCache& GetMemoizedResultCache() {
-    static MemoizedResultCache g_memoizedResultCache;
-    return g_memoizedResultCache;
+void SetLastValidatedHeight(int height, uint32_t changedDeps) {
+    LogPrint(BCLog::RPCCACHE, "RPCCache: set height: %d\n", height);
+    g_lastValidatedHeight.store(height, std::memory_order_release);
+    GetRPCResultCache().InvalidateCaches(changedDeps);
 }
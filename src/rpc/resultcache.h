@@ -1,25 +1,36 @@
 #ifndef DEFI_RPC_RESULTCACHE_H
 #define DEFI_RPC_RESULTCACHE_H
 
+#include <array>
 #include <atomic>
-#include <dfi/balances.h>
 #include <map>
 #include <memory>
 #include <optional>
+#include <rpc/jsonstream.h>
 #include <rpc/request.h>
 #include <string>
 #include <set>
+#include <sync.h>
 #include <uint256.h>
 #include <univalue.h>
+#include <unordered_map>
 
-struct CGetBurnInfoResult {
-    CAmount burntDFI{};
-    CAmount burntFee{};
-    CAmount auctionFee{};
-    CBalances burntTokens;
-    CBalances dexfeeburn;
-    CBalances paybackFee;
-};
+// State a cached result is built from. A result is dropped when a block
+// changes any of its state, results of methods without known dependencies
+// are dropped on every block.
+namespace RPCCacheDeps {
+    static constexpr uint32_t Tokens = 1 << 0;
+    static constexpr uint32_t Pools = 1 << 1;
+    static constexpr uint32_t Accounts = 1 << 2;
+    static constexpr uint32_t Oracles = 1 << 3;
+    static constexpr uint32_t Gov = 1 << 4;
+    static constexpr uint32_t LoanSchemes = 1 << 5;
+    static constexpr uint32_t Block = 1u << 31;
+    static constexpr uint32_t All = ~uint32_t{0};
+}
+
+// Dependencies touched by a write to a key with the given prefix
+uint32_t GetRPCCacheDeps(uint8_t prefix);
 
 class RPCResultCache {
 public:
@@ -30,41 +41,63 @@ public:
     };
 
     void Init(RPCCacheMode mode);
+    bool IsCached(const std::string &method) const;
     std::optional<UniValue> TryGet(const JSONRPCRequest &request);
+    // Serialized result, to be spliced into the reply without executing the request
+    std::shared_ptr<const std::string> TryGetJSON(const JSONRPCRequest &request);
     const UniValue& Set(const JSONRPCRequest &request, const UniValue &value);
-    bool InvalidateCaches();
+    // Stores a result that was only written as JSON, e.g. streamed
+    void SetJSON(const JSONRPCRequest &request, std::string json);
+    bool InvalidateCaches(uint32_t changedDeps = RPCCacheDeps::All);
 
 private:
-    AtomicMutex aMutex;
-    std::set<std::string> smartModeList{};
-    RPCCacheMode mode{RPCCacheMode::None};
-    std::map<std::string, UniValue> cacheMap{};
-    int cacheHeight{0};
+    static constexpr size_t SHARDS = 16;
 
-};
+    struct Entry {
+        UniValue value;
+        std::string json;
+        uint32_t deps;
+    };
 
-RPCResultCache& GetRPCResultCache();
+    struct Shard {
+        AtomicMutex aMutex;
+        std::unordered_map<std::string, std::shared_ptr<const Entry>> entries;
+    };
 
-int GetLastValidatedHeight();
-void SetLastValidatedHeight(int height);
+    std::shared_ptr<const Entry> Find(const JSONRPCRequest &request);
+    Shard& GetShard(const std::string &key);
+    void Store(const JSONRPCRequest &request, UniValue value, std::string json);
 
-struct CMemoizedResultValue {
-    int height;
-    uint256 hash;
-    std::variant<CGetBurnInfoResult> data;
+    std::set<std::string> smartModeList{};
+    std::atomic<RPCCacheMode> mode{RPCCacheMode::None};
+    std::array<Shard, SHARDS> shards;
+    // Bumped on every invalidation, results computed across one are not stored
+    std::atomic<uint64_t> epoch{0};
 };
 
-class MemoizedResultCache {
+RPCResultCache& GetRPCResultCache();
+
+/**
+ * Array result of a list RPC. Items go to the result stream of the request
+ * as they are pushed when it has one, into a UniValue array otherwise. The
+ * result is cached either way.
+ */
+class RPCResultArray {
 public:
-    void Init(RPCResultCache::RPCCacheMode mode);
-    CMemoizedResultValue GetOrDefault(const JSONRPCRequest &request);
-    void Set(const JSONRPCRequest &request, const CMemoizedResultValue &value);
+    explicit RPCResultArray(const JSONRPCRequest &request);
+
+    void push_back(const UniValue &item);
+    // The array, or null when it was streamed
+    UniValue Finish();
+
 private:
-    AtomicMutex aMutex;
-    std::map<std::string, CMemoizedResultValue> cacheMap{};
-    RPCResultCache::RPCCacheMode mode{RPCResultCache::RPCCacheMode::None};
+    const JSONRPCRequest &request;
+    CJSONStreamWriter *stream;
+    bool cached{};
+    UniValue array{UniValue::VARR};
 };
 
-MemoizedResultCache& GetMemoizedResultCache();
+int GetLastValidatedHeight();
+void SetLastValidatedHeight(int height, uint32_t changedDeps = RPCCacheDeps::All);
 
 #endif //DEFI_RPC_RESULTCACHE_H
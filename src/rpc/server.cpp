@@ -7,6 +7,7 @@
 
 #include <fs.h>
 #include <key_io.h>
+#include <rpc/resultcache.h>
 #include <rpc/util.h>
 #include <shutdown.h>
 #include <sync.h>
@@ -444,6 +445,20 @@ UniValue CRPCTable::execute(const JSONRPCRequest &request) const
     throw JSONRPCError(RPC_METHOD_NOT_FOUND, "Method not found");
 }
 
+// Writes a cached result of a streamed request as it was serialized
+static bool WriteCachedResult(const JSONRPCRequest& request)
+{
+    if (!request.resultStream) {
+        return false;
+    }
+    auto json = GetRPCResultCache().TryGetJSON(request);
+    if (!json) {
+        return false;
+    }
+    request.resultStream->Raw(*json);
+    return true;
+}
+
 static bool ExecuteCommand(const CRPCCommand& command, const JSONRPCRequest& request, UniValue& result, bool last_handler)
 {
     try
@@ -451,9 +466,10 @@ static bool ExecuteCommand(const CRPCCommand& command, const JSONRPCRequest& req
         RPCCommandExecution execution(request.strMethod);
         // Execute, convert arguments to array if necessary
         if (request.params.isObject()) {
-            return command.actor(transformNamedArguments(request, command.argNames), result, last_handler);
+            const auto positional = transformNamedArguments(request, command.argNames);
+            return WriteCachedResult(positional) || command.actor(positional, result, last_handler);
         } else {
-            return command.actor(request, result, last_handler);
+            return WriteCachedResult(request) || command.actor(request, result, last_handler);
         }
     }
     catch (const std::exception& e)
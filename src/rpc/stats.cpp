@@ -1,8 +1,10 @@
 #include <rpc/stats.h>
+#include <dfi/processstats.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 
 #include <fstream>
+#include <limits>
 
 bool CRPCStats::isActive() { return active.load(); }
 void CRPCStats::setActive(bool isActive) { active.store(isActive); }
@@ -75,6 +77,7 @@ UniValue RPCStats::toJSON() {
 
     stats.pushKV("name", name);
     stats.pushKV("count", count);
+    stats.pushKV("failed", failed);
     stats.pushKV("lastUsedTime", lastUsedTime);
     stats.pushKV("latency", latencyObj);
     stats.pushKV("payload", payloadObj);
@@ -88,6 +91,9 @@ RPCStats RPCStats::fromJSON(UniValue json) {
     stats.name = json["name"].get_str();
     stats.lastUsedTime = json["lastUsedTime"].get_int64();
     stats.count = json["count"].get_int64();
+    if (!json["failed"].isNull()) {
+        stats.failed = json["failed"].get_int64();
+    }
     if (!json["latency"].isNull()) {
         auto latencyObj  = json["latency"].get_obj();
         stats.latency = {
@@ -121,7 +127,7 @@ RPCStats RPCStats::fromJSON(UniValue json) {
     return stats;
 }
 
-void CRPCStats::add(const std::string& name, const int64_t latency, const int64_t payload)
+void CRPCStats::add(const std::string& name, const int64_t latency, const int64_t payload, const bool failed)
 {
     auto stats = CRPCStats::get(name);
     if (stats) {
@@ -140,6 +146,9 @@ void CRPCStats::add(const std::string& name, const int64_t latency, const int64_
     } else {
         stats = { name, latency, payload };
     }
+    if (failed) {
+        stats->failed++;
+    }
     stats->history.push_back({ stats->lastUsedTime, latency, payload });
 
     std::unique_lock lock(lock_stats);
@@ -169,6 +178,7 @@ static UniValue getrpcstats(const JSONRPCRequest& request)
             "  \"latency\":            (json object) Min, max and average latency.\n"
             "  \"payload\":            (json object) Min, max and average payload size in bytes.\n"
             "  \"count\":              (numeric) The number of times this command as been used.\n"
+            "  \"failed\":             (numeric) The number of times its reply was cut short while streaming.\n"
             "  \"lastUsedTime\":       (numeric) Last used time as timestamp.\n"
             "  \"history\":            (json array) History of last 5 RPC calls.\n"
             "  [\n"
@@ -210,6 +220,7 @@ static UniValue listrpcstats(const JSONRPCRequest& request)
             "  \"latency\":            (json object) Min, max and average latency.\n"
             "  \"payload\":            (json object) Min, max and average payload size in bytes.\n"
             "  \"count\":              (numeric) The number of times this command as been used.\n"
+            "  \"failed\":             (numeric) The number of times its reply was cut short while streaming.\n"
             "  \"lastUsedTime\":       (numeric) Last used time as timestamp.\n"
             "  \"history\":            (json array) History of last 5 RPC calls.\n"
             "  [\n"
@@ -235,12 +246,60 @@ static UniValue listrpcstats(const JSONRPCRequest& request)
     return statsRPC.toJSON();
 }
 
+static UniValue getdefiprocessstats(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"getdefiprocessstats",
+        "\nGet the timings and counters of the DeFi processing of the last connected blocks.\n"
+        "Times are in microseconds.\n",
+        {
+            {"blocks", RPCArg::Type::NUM, /* default */ "all kept", "The number of last blocks to return."}
+        },
+        RPCResult{
+            "{\n"
+            "  \"blocks\":             (json array) The last connected blocks, oldest first.\n"
+            "  [\n"
+            "       {\n"
+            "           \"height\":    (numeric) The block height.\n"
+            "           \"hash\":      (string) The block hash.\n"
+            "           \"time\":      (numeric) Time to connect the block.\n"
+            "           \"stages\":    (json object) Time of each stage of the DeFi events.\n"
+            "           \"customtxs\": (json object) Count and time of each custom tx type.\n"
+            "           \"storage\":   (json object) Database reads, prefetch and decoded cache hits, keys and bytes written.\n"
+            "       }\n"
+            "  ]\n"
+            "  \"stages\":             (json object) Count, total, average, max and histogram of the time of each stage since start.\n"
+            "  \"customtxs\":          (json object) Count, total, average, max and histogram of the time of each custom tx type since start.\n"
+            "}"
+        },
+        RPCExamples{
+            HelpExampleCli("getdefiprocessstats", "10") +
+            HelpExampleRpc("getdefiprocessstats", "10")
+        },
+    }.Check(request);
+
+    if (!deFiProcessStats.IsActive()) {
+        throw JSONRPCError(RPC_INVALID_REQUEST, "DeFi process stats are disabled, see -defiprocessstats.");
+    }
+
+    size_t blocks = std::numeric_limits<size_t>::max();
+    if (!request.params[0].isNull()) {
+        const auto value = request.params[0].get_int();
+        if (value <= 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "blocks must be positive");
+        }
+        blocks = value;
+    }
+
+    return deFiProcessStats.ToJSON(blocks);
+}
+
 // clang-format off
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
     { "stats",              "getrpcstats",            &getrpcstats,            {"command"} },
     { "stats",              "listrpcstats",           &listrpcstats,           {} },
+    { "stats",              "getdefiprocessstats",    &getdefiprocessstats,    {"blocks"} },
 };
 // clang-format on
 
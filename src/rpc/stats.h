@@ -35,6 +35,8 @@ struct RPCStats {
     MinMaxStatEntry latency;
     MinMaxStatEntry payload;
     int64_t count;
+    // Calls whose reply was cut short after it started to stream
+    int64_t failed{0};
     boost::circular_buffer<StatHistoryEntry> history;
 
     RPCStats() : history(RPC_STATS_HISTORY_SIZE) {}
@@ -62,7 +64,7 @@ private:
 public:
     bool isActive();
     void setActive(bool isActive);
-    void add(const std::string& name, const int64_t latency, const int64_t payload);
+    void add(const std::string& name, const int64_t latency, const int64_t payload, const bool failed = false);
     std::optional<RPCStats> get(const std::string& name);
     std::map<std::string, RPCStats> getMap();
     UniValue toJSON();
@@ -118,6 +118,35 @@ BOOST_AUTO_TEST_CASE(dbwrapper_iterator)
     }
 }
 
+// Test raw key/value access, borrowed or de-obfuscated
+BOOST_AUTO_TEST_CASE(dbwrapper_iterator_raw)
+{
+    for (const bool obfuscate : {false, true}) {
+        fs::path ph = GetDataDir() / (obfuscate ? "dbwrapper_iterator_raw_obfuscate_true" : "dbwrapper_iterator_raw_obfuscate_false");
+        CDBWrapper dbw(ph, (1 << 20), true, false, obfuscate);
+
+        char key = 'j';
+        uint256 in = InsecureRand256();
+        BOOST_CHECK(dbw.Write(key, in));
+
+        std::unique_ptr<CDBIterator> it(const_cast<CDBWrapper&>(dbw).NewIterator());
+
+        const std::vector<unsigned char> rawKey{static_cast<unsigned char>(key)};
+        it->SeekRaw(MakeSpan(rawKey));
+        BOOST_REQUIRE(it->Valid());
+
+        const auto keyView = it->GetKeyRaw();
+        BOOST_CHECK(std::vector<unsigned char>(keyView.begin(), keyView.end()) == rawKey);
+
+        std::vector<unsigned char> buffer;
+        const auto valueView = it->GetValueRaw(buffer);
+        BOOST_CHECK_EQUAL(static_cast<size_t>(valueView.size()), in.size());
+        BOOST_CHECK(std::equal(valueView.begin(), valueView.end(), in.begin()));
+        // only obfuscated values are copied
+        BOOST_CHECK_EQUAL(buffer.empty(), !obfuscate);
+    }
+}
+
 // Test that we do not obfuscation if there is existing data.
 BOOST_AUTO_TEST_CASE(existing_data_no_obfuscate)
 {
@@ -511,4 +511,39 @@ BOOST_AUTO_TEST_CASE(owner_rewards)
     });
 }
 
+BOOST_AUTO_TEST_CASE(owner_share_index)
+{
+    CCustomCSView mnview(*pcustomcsview);
+
+    const CScript owner(1), other(2);
+    std::vector<DCT_ID> pools;
+    for (int i = 0; i < 3; ++i) {
+        pools.push_back(std::get<2>(CreatePoolNTokens(mnview, "X"+std::to_string(i), "Y"+std::to_string(i))));
+    }
+    BOOST_CHECK(mnview.SetShare(pools[2], owner, 5));
+    BOOST_CHECK(mnview.SetShare(pools[0], owner, 7));
+    BOOST_CHECK(mnview.SetShare(pools[1], other, 9));
+
+    auto ownerShares = [&](const CScript &address) {
+        std::vector<std::pair<DCT_ID, uint32_t>> shares;
+        mnview.ForEachOwnerShare(address, [&](DCT_ID const &poolId, uint32_t height) {
+            shares.emplace_back(poolId, height);
+            return true;
+        });
+        return shares;
+    };
+
+    auto shares = ownerShares(owner);
+    BOOST_REQUIRE_EQUAL(shares.size(), 2U);
+    BOOST_CHECK(shares[0].first == pools[0] && shares[0].second == 7);
+    BOOST_CHECK(shares[1].first == pools[2] && shares[1].second == 5);
+    BOOST_CHECK_EQUAL(ownerShares(other).size(), 1U);
+
+    BOOST_CHECK(mnview.DelShare(pools[0], owner));
+    shares = ownerShares(owner);
+    BOOST_REQUIRE_EQUAL(shares.size(), 1U);
+    BOOST_CHECK(shares[0].first == pools[2]);
+    BOOST_CHECK(ownerShares(CScript(3)).empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -463,6 +463,25 @@ BOOST_AUTO_TEST_CASE(collateralization_ratio)
     auto colls = mnview.GetVaultAssets(vault_id, *collaterals, 10, 0);
     BOOST_REQUIRE(colls.ok);
     BOOST_CHECK_EQUAL(colls.val->ratio(), 78);
+
+    auto healthy_id = NextTx();
+    BOOST_REQUIRE(mnview.StoreVault(healthy_id, msg));
+    BOOST_REQUIRE(mnview.AddVaultCollateral(healthy_id, {dfi_id, 100 * COIN}));
+    auto unknown_id = NextTx();
+
+    std::vector<std::pair<CVaultId, CBalances>> vaults{
+        {healthy_id, *mnview.GetVaultCollaterals(healthy_id)},
+        {vault_id, *collaterals},
+        {unknown_id, CBalances{{{btc_id, COIN}}}},
+    };
+    auto below = mnview.GetVaultsBelowRatio(vaults, 10, 0);
+    BOOST_REQUIRE_EQUAL(below.size(), 3);
+    BOOST_CHECK(!below[0]);
+    BOOST_CHECK(!below[2]);
+    BOOST_REQUIRE(below[1]);
+    BOOST_CHECK_EQUAL(below[1]->ratio(), 78);
+    BOOST_CHECK_EQUAL(below[1]->totalLoans, colls.val->totalLoans);
+    BOOST_CHECK_EQUAL(below[1]->totalCollaterals, colls.val->totalCollaterals);
 }
 
 BOOST_AUTO_TEST_CASE(auction_batch_creator)
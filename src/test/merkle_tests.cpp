@@ -249,4 +249,28 @@ BOOST_AUTO_TEST_CASE(merkle_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(merkle_reduce_levels)
+{
+    for (int i = 0; i < 32; i++) {
+        const int nleaves = (i <= 16) ? i : 17 + InsecureRandRange(4000);
+        const unsigned int levels = 1 + InsecureRandRange(6);
+        std::vector<uint256> leaves(nleaves);
+        for (auto& leaf : leaves) {
+            leaf = InsecureRand256();
+        }
+        // Reducing aligned chunks first gives the same root
+        const size_t chunk = size_t{1} << levels;
+        std::vector<uint256> roots;
+        for (size_t pos = 0; pos < leaves.size(); pos += chunk) {
+            std::vector<uint256> hashes(leaves.begin() + pos, leaves.begin() + std::min(pos + chunk, leaves.size()));
+            ReduceMerkleLevels(hashes, levels);
+            BOOST_CHECK_EQUAL(hashes.size(), 1U);
+            roots.push_back(hashes[0]);
+        }
+        if (roots.size() > 1) {
+            BOOST_CHECK(ComputeMerkleRoot(roots) == ComputeMerkleRoot(leaves));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
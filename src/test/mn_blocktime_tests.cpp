@@ -115,4 +115,62 @@ BOOST_AUTO_TEST_CASE(retrieve_last_time_multi)
     BOOST_CHECK_EQUAL(time2001[3], 2000);
 }
 
+BOOST_AUTO_TEST_CASE(active_candidates)
+{
+    CCustomCSView mnview(*pcustomcsview.get());
+
+    std::vector<uint256> ids;
+    for (unsigned char i = 1; i <= 3; ++i) {
+        CMasternode mn;
+        CKeyID owner(uint160{std::vector<unsigned char>(20, i)});
+        CKeyID op(uint160{std::vector<unsigned char>(20, 0x10 + i)});
+        mn.operatorType = 1;
+        mn.ownerType = 1;
+        mn.operatorAuthAddress = op;
+        mn.ownerAuthAddress = owner;
+        ids.push_back(uint256(std::vector<unsigned char>(32, i)));
+        BOOST_REQUIRE(mnview.CreateMasternode(ids.back(), mn, 0));
+    }
+
+    auto candidates = [&](int height) {
+        std::set<uint256> result;
+        mnview.ForEachActiveCandidate(
+            [&](const uint256 &id, CMasternode) {
+                result.insert(id);
+                return true;
+            },
+            height);
+        return result;
+    };
+
+    BOOST_CHECK_EQUAL(candidates(1000).size(), 3);
+
+    // Resigned node stays a candidate until the longest resign delay is over
+    const int resignHeight = 1000;
+    auto node = mnview.GetMasternode(ids[1]);
+    BOOST_REQUIRE(node);
+    BOOST_REQUIRE(mnview.ResignMasternode(*node, ids[1], uint256S("aa"), resignHeight));
+
+    const auto &consensus = Params().GetConsensus();
+    const auto inactiveHeight = resignHeight + std::max(consensus.mn.resignDelay, consensus.mn.newResignDelay);
+    BOOST_CHECK_EQUAL(candidates(resignHeight).size(), 3);
+    BOOST_CHECK_EQUAL(candidates(inactiveHeight - 1).size(), 3);
+    BOOST_CHECK(!node->IsActive(inactiveHeight, mnview));
+
+    const auto after = candidates(inactiveHeight);
+    BOOST_CHECK_EQUAL(after.size(), 2);
+    BOOST_CHECK(!after.count(ids[1]));
+
+    // Every node active at a height is a candidate there
+    for (const auto height : {resignHeight - 1, resignHeight, inactiveHeight - 1, inactiveHeight}) {
+        const auto set = candidates(height);
+        mnview.ForEachMasternode([&](const uint256 &id, CMasternode mn) {
+            if (mn.IsActive(height, mnview)) {
+                BOOST_CHECK(set.count(id));
+            }
+            return true;
+        });
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -9,6 +9,7 @@
 #include <dfi/oracles.h>
 #include <rpc/rawtransaction_util.h>
 #include <dfi/masternodes.h>
+#include <dfi/mn_checks.h>
 
 #include <string>
 
@@ -129,4 +130,46 @@ BOOST_FIXTURE_TEST_SUITE(oracles_tests, OraclesTestingSetup)
         BOOST_ASSERT_MSG(dataRes.ok, dataRes.msg.c_str());
     }
 
+    BOOST_AUTO_TEST_CASE(price_feed_index_test) {
+        COracleId oracleId1{rawVector1}, oracleId2{rawVector2};
+        const CTokenCurrencyPair dfiUsd{"DFI", "USD"}, tokUsd{"TOK", "USD"};
+        const int64_t time = 1000000;
+
+        COracle oracle1, oracle2;
+        oracle1.weightage = 1;
+        oracle1.availablePairs = {dfiUsd, tokUsd};
+        oracle2.weightage = 3;
+        oracle2.availablePairs = {dfiUsd};
+
+        CCustomCSView mnview(*pcustomcsview);
+        BOOST_REQUIRE(mnview.AppointOracle(oracleId1, oracle1));
+        BOOST_REQUIRE(mnview.AppointOracle(oracleId2, oracle2));
+        BOOST_REQUIRE(mnview.SetOracleData(oracleId1, time, {{"DFI", {{"USD", 2 * COIN}}}, {"TOK", {{"USD", COIN}}}}));
+        BOOST_REQUIRE(mnview.SetOracleData(oracleId2, time, {{"DFI", {{"USD", 4 * COIN}}}}));
+
+        auto price = GetAggregatePrice(mnview, "DFI", "USD", time);
+        BOOST_REQUIRE(price);
+        BOOST_CHECK_EQUAL(*price.val, 35 * COIN / 10);
+
+        auto prices = GetAggregatePrices(mnview, time);
+        BOOST_REQUIRE_EQUAL(prices.size(), 2);
+        BOOST_REQUIRE(prices.at(dfiUsd));
+        BOOST_CHECK_EQUAL(*prices.at(dfiUsd).val, 35 * COIN / 10);
+        // expired prices don't count
+        BOOST_CHECK(!GetAggregatePrice(mnview, "DFI", "USD", time + 3600));
+
+        // dropping a pair drops its price
+        COracle update;
+        update.weightage = 1;
+        update.availablePairs = {tokUsd};
+        BOOST_REQUIRE(mnview.UpdateOracle(oracleId1, std::move(update)));
+        BOOST_CHECK(!mnview.ExistsBy<COracleView::ByPriceFeed>(COraclePriceFeedKey{dfiUsd, oracleId1}));
+        BOOST_CHECK(mnview.ExistsBy<COracleView::ByPriceFeed>(COraclePriceFeedKey{tokUsd, oracleId1}));
+
+        BOOST_REQUIRE(mnview.RemoveOracle(oracleId2));
+        prices = GetAggregatePrices(mnview, time);
+        BOOST_REQUIRE_EQUAL(prices.size(), 1);
+        BOOST_CHECK(prices.count(tokUsd));
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
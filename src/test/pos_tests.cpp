@@ -70,6 +70,54 @@ BOOST_AUTO_TEST_CASE(calc_kernel)
 //    BOOST_CHECK(pos::ComputeStakeModifier(prevStakeModifier, keyID) == targetStakeModifier);
 }
 
+BOOST_AUTO_TEST_CASE(kernel_search)
+{
+    const auto& params = Params().GetConsensus();
+    const auto stakeModifier = uint256S("1234567890abcdef1234567890abcdef1234567890abcdef1234567890abcdef");
+    const std::vector<pos::KernelCandidate> candidates{
+        {stakeModifier, 1, uint256S("fedcba0987654321fedcba0987654321fedcba0987654321fedcba0987654321"), 0, 0},
+        {stakeModifier, 1, uint256S("fedcba0987654321fedcba0987654321fedcba0987654321fedcba0987654321"), 50000, 1},
+        {stakeModifier, 1, uint256S("fedcba0987654321fedcba0987654321fedcba0987654321fedcba0987654321"), 90000, 2},
+        {uint256S("abcdef"), 2, uint256S("0123456789"), 20000, 0},
+    };
+
+    std::vector<int64_t> times;
+    for (int64_t time = 100000; time < 100200; ++time) {
+        times.push_back(time);
+    }
+
+    for (const uint64_t blockHeight : {uint64_t{0},
+                                       static_cast<uint64_t>(params.DF7DakotaCrescentHeight),
+                                       static_cast<uint64_t>(params.DF10EunosPayaHeight)}) {
+        for (const uint32_t nBits : {0x1effffffU, 0x1b00ffffU, 0x1a00ffffU, 0x00ffffffU}) {
+            pos::CKernelSearch search(nBits, blockHeight, params);
+            for (const auto& candidate : candidates) {
+                search.AddCandidate(candidate);
+            }
+            BOOST_CHECK_EQUAL(search.Size(), candidates.size());
+
+            // First time and candidate found by checking them one by one
+            std::optional<std::pair<int64_t, size_t>> expected;
+            for (const auto time : times) {
+                for (size_t i = 0; i < candidates.size() && !expected; ++i) {
+                    const auto& candidate = candidates[i];
+                    CheckContextState ctxState{candidate.subNode};
+                    if (pos::CheckKernelHash(candidate.stakeModifier, nBits, candidate.creationHeight, time, blockHeight,
+                                             candidate.masternodeID, params, candidate.subNodeBlockTime, ctxState)) {
+                        expected = std::make_pair(time, i);
+                    }
+                }
+                if (expected) {
+                    break;
+                }
+            }
+
+            const auto result = search.Search(times);
+            BOOST_CHECK(result == expected);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(check_stake_modifier)
 {
     uint256 masternodeID = testMasternodeKeys.begin()->first;
@@ -128,6 +176,32 @@ BOOST_AUTO_TEST_CASE(check_header_signature)
 //    BOOST_CHECK(!pos::CheckHeaderSignature(*(CBlockHeader*)block.get()));
 }
 
+BOOST_AUTO_TEST_CASE(recover_header_signatures)
+{
+    uint256 masternodeID = testMasternodeKeys.begin()->first;
+    CKey minterKey = testMasternodeKeys.begin()->second.operatorKey;
+
+    uint256 prev_hash = uint256S("fedcba0987654321fedcba0987654321fedcba0987654321fedcba0987654321");
+    std::shared_ptr<CBlock> block = FinalizeBlock(Block(prev_hash, 1, 1), masternodeID, minterKey, prev_hash);
+
+    std::vector<CBlockHeader> headers{block->GetBlockHeader(), block->GetBlockHeader(), Params().GenesisBlock().GetBlockHeader()};
+    headers[1].sig.resize(10);
+    BOOST_CHECK(!headers[0].GetRecoveredPubKey().IsValid());
+
+    pos::RecoverHeaderSignatures(headers);
+
+    BOOST_CHECK(headers[0].GetRecoveredPubKey() == minterKey.GetPubKey());
+    BOOST_CHECK(!headers[1].GetRecoveredPubKey().IsValid());
+    BOOST_CHECK(pos::CheckHeaderSignature(headers[0]));
+    BOOST_CHECK(!pos::CheckHeaderSignature(headers[1]));
+    BOOST_CHECK(pos::CheckHeaderSignature(headers[2]));
+
+    // A fresh copy of the header picks the key up from the cache
+    const auto header = block->GetBlockHeader();
+    BOOST_CHECK(pos::CheckHeaderSignature(header));
+    BOOST_CHECK(header.GetRecoveredPubKey() == minterKey.GetPubKey());
+}
+
 BOOST_AUTO_TEST_CASE(contextual_check_pos)
 {
     uint256 masternodeID = testMasternodeKeys.begin()->first;
@@ -4,6 +4,8 @@
 
 #include <rpc/server.h>
 #include <rpc/client.h>
+#include <rpc/jsonstream.h>
+#include <rpc/resultcache.h>
 #include <rpc/util.h>
 
 #include <core_io.h>
@@ -452,4 +454,115 @@ BOOST_AUTO_TEST_CASE(rpc_getblockstats_calculate_percentiles_by_weight)
     }
 }
 
+BOOST_AUTO_TEST_CASE(rpc_json_stream)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("a\"b", "x\n\t\x01\x7f\\ \xc3\xa9");
+    obj.pushKV("int", -12345);
+    obj.pushKV("amount", ValueFromAmount(123456789));
+    obj.pushKV("flag", true);
+    obj.pushKV("none", NullUniValue);
+    UniValue arr(UniValue::VARR);
+    for (int i = 0; i < 100; ++i) {
+        UniValue item(UniValue::VOBJ);
+        item.pushKV("i", i);
+        item.pushKV("s", std::string(i % 7, 'q'));
+        arr.push_back(item);
+    }
+    arr.push_back(UniValue(UniValue::VARR));
+    obj.pushKV("arr", arr);
+
+    std::string out;
+    size_t chunks{};
+    CJSONStreamWriter writer([&](std::string &&chunk) {
+        out += chunk;
+        ++chunks;
+    }, 64);
+    writer.BeginArray();
+    writer.Value(obj);
+    writer.Value("str");
+    writer.Value(uint64_t{std::numeric_limits<uint64_t>::max()});
+    writer.Raw("{\"raw\":1}");
+    writer.EndArray();
+    BOOST_CHECK(writer.Flushed());
+    out += writer.Release();
+
+    UniValue expected(UniValue::VARR);
+    expected.push_back(obj);
+    expected.push_back("str");
+    expected.push_back(uint64_t{std::numeric_limits<uint64_t>::max()});
+    UniValue raw(UniValue::VOBJ);
+    raw.pushKV("raw", 1);
+    expected.push_back(raw);
+
+    // Same output as UniValue::write, cut into chunks
+    BOOST_CHECK_EQUAL(out, expected.write());
+    BOOST_CHECK_EQUAL(writer.Size(), out.size());
+    BOOST_CHECK(chunks > 1);
+}
+
+BOOST_AUTO_TEST_CASE(rpc_result_cache)
+{
+    auto &cache = GetRPCResultCache();
+    cache.Init(RPCResultCache::RPCCacheMode::All);
+
+    auto request = [](const std::string &method) {
+        JSONRPCRequest req;
+        req.strMethod = method;
+        req.params = UniValue(UniValue::VARR);
+        req.params.push_back(method);
+        req.id = 1;
+        return req;
+    };
+    const auto pools = request("listpoolpairs");
+    const auto oracles = request("listoracles");
+    const auto blocks = request("getblockchaininfo");
+
+    UniValue value(UniValue::VOBJ);
+    value.pushKV("a", 1);
+    for (const auto &req : {pools, oracles, blocks}) {
+        BOOST_CHECK(!cache.TryGet(req));
+        cache.Set(req, value);
+    }
+    BOOST_CHECK_EQUAL(cache.TryGet(pools)->write(), value.write());
+    BOOST_CHECK_EQUAL(*cache.TryGetJSON(pools), value.write());
+
+    // Only the results depending on the changed state are dropped
+    cache.InvalidateCaches(RPCCacheDeps::Block | RPCCacheDeps::Oracles);
+    BOOST_CHECK(cache.TryGet(pools));
+    BOOST_CHECK(!cache.TryGet(oracles));
+    BOOST_CHECK(!cache.TryGet(blocks));
+
+    // A result built across an invalidation is not stored
+    BOOST_CHECK(!cache.TryGet(oracles));
+    cache.InvalidateCaches(RPCCacheDeps::Block);
+    cache.Set(oracles, value);
+    BOOST_CHECK(!cache.TryGet(oracles));
+
+    cache.InvalidateCaches();
+    BOOST_CHECK(!cache.TryGet(pools));
+
+    // A streamed array is written out in chunks and cached as it was written
+    auto vaults = request("listvaults");
+    std::string out;
+    CJSONStreamWriter writer([&](std::string &&chunk) { out += chunk; }, 16);
+    writer.BeginObject();
+    writer.Key("result");
+    vaults.resultStream = &writer;
+    BOOST_CHECK(!cache.TryGetJSON(vaults));
+    RPCResultArray items(vaults);
+    UniValue expected(UniValue::VARR);
+    for (int i = 0; i < 10; ++i) {
+        items.push_back(value);
+        expected.push_back(value);
+    }
+    BOOST_CHECK(items.Finish().isNull());
+    writer.EndObject();
+    out += writer.Release();
+    BOOST_CHECK_EQUAL(out, "{\"result\":" + expected.write() + "}");
+    BOOST_CHECK_EQUAL(*cache.TryGetJSON(vaults), expected.write());
+    BOOST_CHECK_EQUAL(cache.TryGet(vaults)->write(), expected.write());
+    cache.Init(RPCResultCache::RPCCacheMode::None);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,8 @@
 
 #include <interfaces/chain.h>
 #include <key_io.h>
+#include <dfi/accountshistory.h>
+#include <dfi/govvariables/attributes.h>
 #include <dfi/masternodes.h>
 #include <dfi/mn_checks.h>
 #include <rpc/rawtransaction_util.h>
@@ -98,6 +100,8 @@ BOOST_AUTO_TEST_CASE(undo)
     BOOST_CHECK(undo.before.size() == 2);
     BOOST_CHECK(undo.before.at(ToBytes("testkey1")) == ToBytes("value0"));
     BOOST_CHECK(undo.before.at(ToBytes("testkey2")).has_value() == false);
+    // streamed undo has the same encoding
+    BOOST_CHECK(CUndo::ConstructRaw(base_raw, flushable.GetRaw()) == DbTypeToBytes(undo));
 
     // flush changes
     mnview.Flush();
@@ -443,4 +447,305 @@ BOOST_AUTO_TEST_CASE(LowerBoundTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(ArenaMapKVKeys)
+{
+    // keys around the inline storage boundary must keep byte-wise ordering
+    std::vector<TBytes> keys;
+    for (auto size : {size_t{1}, size_t{KV_KEY_INLINE_SIZE - 1}, size_t{KV_KEY_INLINE_SIZE}, size_t{KV_KEY_INLINE_SIZE + 1}, size_t{100}}) {
+        keys.emplace_back(size, 0x01);
+        keys.emplace_back(size, 0xff);
+    }
+
+    CCustomCSView view(*pcustomcsview);
+    auto& storage = view.GetStorage();
+    for (const auto& key : keys) {
+        BOOST_CHECK(storage.Write(key, key));
+    }
+    BOOST_CHECK(storage.Erase(keys[4]));
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::find(keys.begin(), keys.end(), TBytes(KV_KEY_INLINE_SIZE, 0x01)));
+
+    auto& raw = storage.GetRaw();
+    BOOST_CHECK_EQUAL(raw.size(), keys.size() + 1);
+    BOOST_CHECK(raw.find(TBytes(KV_KEY_INLINE_SIZE, 0x01)) != raw.end());
+    BOOST_CHECK(!raw.find(TBytes(KV_KEY_INLINE_SIZE, 0x01))->second);
+
+    // single level iterator, erased key must be skipped
+    auto it = std::make_unique<CFlushableStorageKVIterator>(std::make_unique<CStorageKVEmptyIterator>(), raw);
+    auto expected = keys.begin();
+    for (it->Seek({}); it->Valid() && expected != keys.end(); it->Next(), ++expected) {
+        BOOST_CHECK(it->Key() == *expected);
+        BOOST_CHECK(it->Value() == *expected);
+    }
+    BOOST_CHECK(expected == keys.end());
+
+    for (const auto& key : keys) {
+        TBytes value;
+        BOOST_CHECK(storage.Read(key, value));
+        BOOST_CHECK(value == key);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DecodedCache)
+{
+    CCustomCSView base(*pcustomcsview);
+    const auto key = std::make_pair(uint8_t{0xFA}, std::string{"cached"});
+    BOOST_CHECK(!base.ReadCached<int>(key));
+
+    BOOST_CHECK(base.Write(key, 1));
+    const auto first = base.ReadCached<int>(key);
+    BOOST_REQUIRE(first);
+    BOOST_CHECK_EQUAL(*first, 1);
+    // same object until the key is written
+    BOOST_CHECK(base.ReadCached<int>(key) == first);
+
+    {
+        // nested views see the parent object
+        CCustomCSView view(base);
+        BOOST_CHECK(view.ReadCached<int>(key) == first);
+
+        BOOST_CHECK(view.Write(key, 2));
+        const auto second = view.ReadCached<int>(key);
+        BOOST_REQUIRE(second);
+        BOOST_CHECK_EQUAL(*second, 2);
+        BOOST_CHECK_EQUAL(*base.ReadCached<int>(key), 1);
+
+        // flush hands the decoded object down
+        view.Flush();
+        BOOST_CHECK(base.ReadCached<int>(key) == second);
+    }
+
+    {
+        CCustomCSView view(base);
+        BOOST_CHECK_EQUAL(*view.ReadCached<int>(key), 2);
+        // writes below invalidate objects cached above
+        BOOST_CHECK(base.Write(key, 3));
+        BOOST_CHECK_EQUAL(*view.ReadCached<int>(key), 3);
+        BOOST_CHECK(base.Erase(key));
+        BOOST_CHECK(!view.ReadCached<int>(key));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(AttributesPerKey)
+{
+    CCustomCSView base(*pcustomcsview);
+    const CDataStructureV0 active{AttributeTypes::Param, ParamIDs::DFIP2201, DFIPKeys::Active};
+    const CDataStructureV0 premium{AttributeTypes::Param, ParamIDs::DFIP2201, DFIPKeys::Premium};
+
+    auto attributes = base.CopyAttributes();
+    attributes->SetValue(active, true);
+    attributes->SetValue(premium, CAmount{COIN});
+    BOOST_CHECK(base.SetVariable(*attributes));
+    BOOST_CHECK(base.ExistsBy<CGovView::ByAttribute>(CAttributeType{active}));
+    BOOST_CHECK(base.ExistsBy<CGovView::ByAttribute>(CAttributeType{premium}));
+
+    {
+        // only the changed key is written
+        CCustomCSView view(base);
+        auto update = view.CopyAttributes();
+        BOOST_CHECK(update->EraseKey(premium));
+        BOOST_CHECK(view.SetVariable(*update));
+        const auto result = view.GetAttributes();
+        BOOST_CHECK(result->GetValue(active, false));
+        BOOST_CHECK(!result->CheckKey(premium));
+        BOOST_CHECK(!view.ExistsBy<CGovView::ByAttribute>(CAttributeType{premium}));
+        BOOST_CHECK(base.GetAttributes()->CheckKey(premium));
+        view.Flush();
+    }
+
+    BOOST_CHECK(!base.GetAttributes()->CheckKey(premium));
+    // the gov variable view of the attributes is assembled from the keys
+    const auto var = std::dynamic_pointer_cast<ATTRIBUTES>(base.GetVariable("ATTRIBUTES"));
+    BOOST_REQUIRE(var);
+    BOOST_CHECK(var->GetValue(active, false));
+
+    {
+        // a key set and erased again still leaves an entry, as the blob did
+        CCustomCSView view(base);
+        auto update = view.CopyAttributes();
+        update->SetValue(premium, CAmount{COIN});
+        BOOST_CHECK(update->EraseKey(premium));
+        BOOST_CHECK(view.SetVariable(*update));
+        BOOST_CHECK(!view.GetStorage().GetRaw().empty());
+        BOOST_CHECK(!view.GetAttributes()->CheckKey(premium));
+    }
+
+    {
+        // without attributes before or after the blob was not written either
+        CCustomCSView empty(*pcustomcsview);
+        CCustomCSView view(empty);
+        auto update = view.CopyAttributes();
+        BOOST_REQUIRE(update->GetAttributesMap().empty());
+        update->SetValue(premium, CAmount{COIN});
+        BOOST_CHECK(update->EraseKey(premium));
+        BOOST_CHECK(view.SetVariable(*update));
+        BOOST_CHECK(view.GetStorage().GetRaw().empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BurnHistoryTotals)
+{
+    CBurnHistoryStorage burnView(GetDataDir() / "burntotals", nMinDbCache << 20, true, true);
+    burnView.CreateTotalsIfNeeded();
+    const auto burnAddress = Params().GetConsensus().burnAddress;
+
+    const AccountHistoryKey utxoKey{burnAddress, 10, 1};
+    const AccountHistoryKey swapKey{burnAddress, 10, 2};
+    const AccountHistoryKey tokenKey{burnAddress, 11, 1};
+    burnView.WriteAccountHistory(utxoKey, {{}, uint8_t(CustomTxType::None), {{DCT_ID{0}, 5 * COIN}}});
+    burnView.WriteAccountHistory(swapKey, {{}, uint8_t(CustomTxType::PoolSwap), {{DCT_ID{1}, COIN}}});
+    burnView.WriteAccountHistory(tokenKey, {{}, uint8_t(CustomTxType::BurnToken), {{DCT_ID{2}, 2 * COIN}}});
+    // rewriting an entry not flushed yet replaces its amounts
+    burnView.WriteAccountHistory(utxoKey, {{}, uint8_t(CustomTxType::None), {{DCT_ID{0}, 3 * COIN}}});
+    BOOST_CHECK(burnView.Flush());
+
+    auto totals = burnView.GetBurnTotals();
+    BOOST_CHECK_EQUAL(totals.burntDFI, 3 * COIN);
+    BOOST_CHECK_EQUAL(totals.dexfeeburn.balances[DCT_ID{1}], COIN);
+    BOOST_CHECK_EQUAL(totals.burntTokens.balances[DCT_ID{2}], 2 * COIN);
+
+    // disconnecting a block takes its burns out
+    BOOST_CHECK(burnView.EraseAccountHistoryHeight(11));
+    BOOST_CHECK(burnView.Flush());
+    totals = burnView.GetBurnTotals();
+    BOOST_CHECK(totals.burntTokens.balances.empty());
+    BOOST_CHECK_EQUAL(totals.burntDFI, 3 * COIN);
+
+    // a database without totals gets them from its history
+    BOOST_CHECK(burnView.Erase(CBurnHistoryStorage::ByBurnTotals::prefix()));
+    BOOST_CHECK(burnView.Flush());
+    burnView.CreateTotalsIfNeeded();
+    BOOST_CHECK_EQUAL(burnView.GetBurnTotals().burntDFI, 3 * COIN);
+    BOOST_CHECK_EQUAL(burnView.GetBurnTotals().dexfeeburn.balances.at(DCT_ID{1}), COIN);
+}
+
+BOOST_AUTO_TEST_CASE(PrefetchReads)
+{
+    CStorageLevelDB db(GetDataDir() / "prefetch", nMinDbCache << 20, true, true);
+    const auto key1 = ToBytes("key1"), key2 = ToBytes("key2"), missing = ToBytes("missing");
+    BOOST_CHECK(db.Write(key1, ToBytes("value1")));
+    BOOST_CHECK(db.Write(key2, ToBytes("value2")));
+    BOOST_CHECK(db.Flush());
+
+    TBytes value;
+    db.Prefetch({key1, missing});
+    BOOST_CHECK(db.Read(key1, value));
+    BOOST_CHECK(value == ToBytes("value1"));
+    BOOST_CHECK(!db.Read(missing, value));
+    // a prefetched entry is taken out by the read, the next one reads the database
+    BOOST_CHECK(db.Read(key1, value));
+    BOOST_CHECK(value == ToBytes("value1"));
+
+    // a flush drops what was prefetched before it
+    db.Prefetch({key2, missing});
+    BOOST_CHECK(db.Write(key2, ToBytes("changed")));
+    BOOST_CHECK(db.Write(missing, ToBytes("added")));
+    BOOST_CHECK(db.Flush());
+    BOOST_CHECK(db.Read(key2, value));
+    BOOST_CHECK(value == ToBytes("changed"));
+    BOOST_CHECK(db.Read(missing, value));
+    BOOST_CHECK(value == ToBytes("added"));
+}
+
+BOOST_AUTO_TEST_CASE(RecordedReads)
+{
+    CStorageLevelDB db(GetDataDir() / "recording", nMinDbCache << 20, true, true);
+    CFlushableStorageKV base(db);
+    const auto key1 = ToBytes("a1"), key2 = ToBytes("a2"), key3 = ToBytes("b1");
+    BOOST_CHECK(base.Write(key1, ToBytes("value1")));
+    BOOST_CHECK(base.Write(key3, ToBytes("value3")));
+
+    CRecordingStorageKV reads(base);
+    CFlushableStorageKV view(reads);
+    TBytes value;
+    BOOST_CHECK(view.Read(key1, value));
+    BOOST_CHECK(!view.Exists(key2));
+    {
+        auto it = view.NewIterator();
+        it->Seek(ToBytes("b"));
+        BOOST_CHECK(it->Valid());
+        it->Next();
+        BOOST_CHECK(!it->Valid());
+    }
+    // changes stay in the view above
+    BOOST_CHECK(view.Write(key2, ToBytes("value2")));
+    BOOST_CHECK(!base.Exists(key2));
+    BOOST_CHECK(reads.GetReads().Validate(base));
+
+    // a write outside of what was read keeps the reads valid
+    BOOST_CHECK(base.Write(ToBytes("a0"), ToBytes("value0")));
+    BOOST_CHECK(reads.GetReads().Validate(base));
+
+    // changing a read key, adding a missing one or a key in a scanned range does not
+    BOOST_CHECK(base.Write(key1, ToBytes("changed")));
+    BOOST_CHECK(!reads.GetReads().Validate(base));
+    BOOST_CHECK(base.Write(key1, ToBytes("value1")));
+    BOOST_CHECK(reads.GetReads().Validate(base));
+    BOOST_CHECK(base.Write(key2, ToBytes("value2")));
+    BOOST_CHECK(!reads.GetReads().Validate(base));
+    BOOST_CHECK(base.Erase(key2));
+    BOOST_CHECK(reads.GetReads().Validate(base));
+    BOOST_CHECK(base.Write(ToBytes("b2"), ToBytes("value4")));
+    BOOST_CHECK(!reads.GetReads().Validate(base));
+}
+
+BOOST_AUTO_TEST_CASE(RecordedDecodedReads)
+{
+    CCustomCSView block(*pcustomcsview);
+    const CDataStructureV0 active{AttributeTypes::Param, ParamIDs::DFIP2201, DFIPKeys::Active};
+    auto attributes = block.CopyAttributes();
+    attributes->SetValue(active, true);
+    BOOST_CHECK(block.SetVariable(*attributes));
+    const auto cached = block.GetAttributes();
+
+    // the view above the recording layer shares the object of the block view
+    CRecordingStorageKV reads(block.GetStorage());
+    CCustomCSView view(reads);
+    BOOST_CHECK(view.GetAttributes() == cached);
+    BOOST_CHECK(reads.GetReads().Validate(block.GetStorage()));
+
+    // a write to any attribute drops the object and with it the read
+    attributes = block.CopyAttributes();
+    attributes->SetValue(active, false);
+    BOOST_CHECK(block.SetVariable(*attributes));
+    BOOST_CHECK(!reads.GetReads().Validate(block.GetStorage()));
+}
+
+BOOST_AUTO_TEST_CASE(SharedSnapshotChanges)
+{
+    auto db = std::make_unique<CStorageLevelDB>(GetDataDir() / "snapshot", nMinDbCache << 20, true, true);
+    BOOST_CHECK(db->Write(ToBytes("a1"), ToBytes("value1")));
+    BOOST_CHECK(db->Write(ToBytes("a3"), ToBytes("value3")));
+    BOOST_CHECK(db->Flush());
+
+    // changes not flushed to the database at the snapshot block
+    auto changed = std::make_shared<ArenaMapKV>();
+    changed->emplace(ToKeyBytes(ToBytes("a2")), ToBytes("value2"));
+    changed->emplace(ToKeyBytes(ToBytes("a3")), std::nullopt);
+    const std::shared_ptr<const ArenaMapKV> shared = changed;
+
+    CFlushableStorageKV view(db, shared);
+    BOOST_CHECK_EQUAL(shared.use_count(), 3);
+
+    TBytes value;
+    BOOST_CHECK(view.Read(ToBytes("a2"), value));
+    BOOST_CHECK(value == ToBytes("value2"));
+    BOOST_CHECK(!view.Exists(ToBytes("a3")));
+    BOOST_CHECK(view.Read(ToBytes("a1"), value));
+
+    // writes stay in the view, the shared changes are left as they are
+    BOOST_CHECK(view.Write(ToBytes("a3"), ToBytes("changed")));
+    BOOST_CHECK(view.Erase(ToBytes("a2")));
+    BOOST_CHECK_EQUAL(shared->size(), 2);
+    BOOST_CHECK(!shared->at(ToKeyBytes(ToBytes("a3"))));
+
+    const std::map<TBytes, TBytes> expected{
+        {ToBytes("a1"), ToBytes("value1")},
+        {ToBytes("a3"), ToBytes("changed")},
+    };
+    BOOST_CHECK(TakeSnapshot(view) == expected);
+    BOOST_CHECK_THROW(view.Flush(), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,133 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <dfi/threadpool.h>
+
+#include <test/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct TaskPoolSetup : public BasicTestingSetup {
+    TaskPoolSetup() { DfTxTaskPool = std::make_unique<TaskPool>(3); }
+    ~TaskPoolSetup() {
+        DfTxTaskPool->Shutdown();
+        DfTxTaskPool.reset();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(threadpool_tests, TaskPoolSetup)
+
+BOOST_AUTO_TEST_CASE(parallel_for)
+{
+    std::vector<uint64_t> values(100000);
+    std::iota(values.begin(), values.end(), 0);
+    std::atomic<uint64_t> sum{0};
+    ParallelFor(values.size(), 100, [&](size_t begin, size_t end) {
+        uint64_t partial{};
+        for (auto i = begin; i < end; ++i) {
+            partial += values[i];
+        }
+        sum += partial;
+    });
+    BOOST_CHECK_EQUAL(sum.load(), uint64_t{4999950000});
+
+    // exceptions are passed to the caller
+    BOOST_CHECK_THROW(ParallelFor(100, 1, [](size_t begin, size_t) {
+        if (begin == 50) {
+            throw std::runtime_error("task");
+        }
+    }), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_reduce_order)
+{
+    const auto result = ParallelReduce(
+        1000, 7, std::string{},
+        [](size_t begin, size_t) { return std::to_string(begin) + ","; },
+        [](std::string total, const std::string &part) { return total + part; });
+    std::string expected;
+    for (size_t begin = 0; begin < 1000; begin += 7) {
+        expected += std::to_string(begin) + ",";
+    }
+    BOOST_CHECK_EQUAL(result, expected);
+}
+
+BOOST_AUTO_TEST_CASE(nested_and_cancelled)
+{
+    // tasks waiting on nested work can't starve the pool
+    TaskGroup g;
+    std::atomic<int> items{0};
+    for (int i = 0; i < 20; ++i) {
+        DfTxTaskPool->Post(g, [&] {
+            ParallelFor(1000, 10, [&](size_t begin, size_t end) { items += end - begin; });
+        });
+    }
+    g.WaitForCompletion();
+    BOOST_CHECK_EQUAL(items.load(), 20000);
+
+    TaskGroup cancelled;
+    std::atomic<int> ran{0};
+    cancelled.MarkCancelled();
+    for (int i = 0; i < 100; ++i) {
+        DfTxTaskPool->Post(cancelled, [&] { ++ran; });
+    }
+    cancelled.WaitForCompletion();
+    BOOST_CHECK_EQUAL(ran.load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(busy_pool_and_failures)
+{
+    // a loop doesn't wait for helpers stuck behind other work
+    TaskGroup busy;
+    std::atomic<bool> release{false};
+    for (size_t i = 0; i < DfTxTaskPool->GetAvailableThreads(); ++i) {
+        DfTxTaskPool->Post(busy, [&] {
+            while (!release) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+        });
+    }
+    std::atomic<int> items{0};
+    ParallelFor(1000, 10, [&](size_t begin, size_t end) { items += end - begin; });
+    BOOST_CHECK_EQUAL(items.load(), 1000);
+    release = true;
+    busy.WaitForCompletion();
+
+    // the first failure of a group cancels the rest and reaches the waiter
+    TaskGroup failing;
+    DfTxTaskPool->Post(failing, [] { throw std::runtime_error("task"); });
+    BOOST_CHECK_THROW(failing.WaitForCompletion(), std::runtime_error);
+    BOOST_CHECK(failing.IsCancelled());
+
+    // a failing task without a group doesn't take the worker down
+    DfTxTaskPool->Post([] { throw std::runtime_error("task"); });
+    ParallelFor(100, 1, [&](size_t begin, size_t end) { items += end - begin; });
+    BOOST_CHECK_EQUAL(items.load(), 1100);
+}
+
+BOOST_AUTO_TEST_CASE(post_during_shutdown)
+{
+    // every task runs, queued before the workers exit or inline after
+    TaskPool pool(2);
+    std::atomic<int> ran{0};
+    std::thread poster([&] {
+        for (int i = 0; i < 10000; ++i) {
+            pool.Post([&] { ++ran; });
+            if (i % 100 == 0) {
+                pool.PostBatch({[&] { ++ran; }, [&] { ++ran; }});
+            }
+        }
+    });
+    pool.Shutdown();
+    poster.join();
+    BOOST_CHECK_EQUAL(ran.load(), 10200);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -13,6 +13,7 @@
 #include <dfi/errors.h>
 #include <dfi/govvariables/attributes.h>
 #include <dfi/mn_checks.h>
+#include <dfi/speculativetx.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
@@ -1273,10 +1274,31 @@ void CTxMemPool::rebuildAccountsView(int height, const CCoinsViewCache &coinsCac
     std::vector<CTransactionRef> vtx;
 
     const auto isEvmEnabledForBlock = IsEVMEnabled(viewDuplicate);
+    auto &txsByEntryTime = mapTx.get<entry_time>();
+
+    // Contexts of all the txs are needed up front to run them ahead. The
+    // vectors must not reallocate, the tx contexts refer to the block ones.
+    std::vector<BlockContext> blockContexts;
+    std::vector<TransactionContext> txContexts;
+    blockContexts.reserve(mapTx.size());
+    txContexts.reserve(mapTx.size());
+    CSpeculativeCustomTxs speculativeTxs(g_parallel_custom_tx_mode, viewDuplicate);
+    for (const auto &entry : txsByEntryTime) {
+        auto &blockCtx = blockContexts.emplace_back(static_cast<uint32_t>(height),
+                                                    static_cast<uint64_t>(entry.GetTime()),
+                                                    Params().GetConsensus(),
+                                                    &viewDuplicate,
+                                                    isEvmEnabledForBlock,
+                                                    std::shared_ptr<CScopedTemplate>{},
+                                                    true);
+        auto &txCtx = txContexts.emplace_back(coinsCache, entry.GetTx(), blockCtx);
+        speculativeTxs.Add(blockCtx, txCtx);
+    }
+    speculativeTxs.Execute();
 
     // Check custom TX consensus types are now not in conflict with account layer
-    auto &txsByEntryTime = mapTx.get<entry_time>();
-    for (auto it = txsByEntryTime.begin(); it != txsByEntryTime.end(); ++it) {
+    size_t index{};
+    for (auto it = txsByEntryTime.begin(); it != txsByEntryTime.end(); ++it, ++index) {
         CValidationState state;
         const auto &tx = it->GetTx();
         const auto removeTxBackToStage = [&it](const indexed_transaction_set &mapTx,
@@ -1292,27 +1314,15 @@ void CTxMemPool::rebuildAccountsView(int height, const CCoinsViewCache &coinsCac
             removeTxBackToStage(mapTx, staged, vtx, tx);
             continue;
         }
-        auto blockCtx = BlockContext{
-            static_cast<uint32_t>(height),
-            static_cast<uint64_t>(it->GetTime()),
-            Params().GetConsensus(),
-            &viewDuplicate,
-            isEvmEnabledForBlock,
-            {},
-            true,
-        };
-        auto txCtx = TransactionContext{
-            coinsCache,
-            tx,
-            blockCtx,
-        };
-        auto res = ApplyCustomTx(blockCtx, txCtx);
+        auto res = speculativeTxs.Apply(index);
 
         if (!res && (res.code & CustomTxErrCodes::Fatal)) {
             removeTxBackToStage(mapTx, staged, vtx, tx);
         }
     }
 
+    speculativeTxs.LogStats("mempool");
+
     RemoveStaged(staged, true, MemPoolRemovalReason::BLOCK);
 
     for (const auto &tx : vtx) {
@@ -21,6 +21,8 @@
 #include <dfi/govvariables/attributes.h>
 #include <dfi/historywriter.h>
 #include <dfi/mn_checks.h>
+#include <dfi/processstats.h>
+#include <dfi/speculativetx.h>
 #include <dfi/threadpool.h>
 #include <dfi/validation.h>
 #include <dfi/vaulthistory.h>
@@ -2598,10 +2600,18 @@ bool StopOrInterruptConnect(const CBlockIndex *pIndex, CValidationState &state)
     return false;
 }
 
+// Txs per task when decoding and prefetching the custom txs of a block
+static constexpr size_t CUSTOM_TX_DECODE_CHUNK_SIZE = 32;
+static constexpr size_t CUSTOM_TX_PREFETCH_CHUNK_SIZE = 16;
+
 static void LogApplyCustomTx(TransactionContext &txCtx, const int64_t start) {
     const auto &tx = txCtx.GetTransaction();
     const auto txType = txCtx.GetTxType();
 
+    if (txType != CustomTxType::None && deFiProcessStats.IsActive()) {
+        deFiProcessStats.AddTx(txType, GetTimeMicros() - start);
+    }
+
     // Only log once for one of the following categories. Log BENCH first for consistent formatting.
     if (LogAcceptCategory(BCLog::BENCH)) {
         std::vector<unsigned char> metadata;
@@ -3019,11 +3029,48 @@ bool CChainState::ConnectBlock(const CBlock &block,
     auto isEvmEnabledForBlock = blockCtx.GetEVMEnabledForBlock();
     auto &evmTemplate = blockCtx.GetEVMTemplate();
 
-    // Note: TaskGroup needs to be alive until the end of the boost IO pool completion.
+    // Note: TaskGroup needs to be alive until the end of the DfTx pool completion.
     // So, we allocate it outside of the pre-cache scope, and ensure it's cancelled on
     // all return paths.
     TaskGroup evmEccPreCacheTaskPool;
-    std::map<size_t, TransactionContext> txContexts;
+    TaskGroup prefetchTaskGroup;
+
+    // Decode the custom tx metadata of the whole block up front, it only depends
+    // on the tx and the block height
+    std::vector<TransactionContext> txContexts;
+    txContexts.reserve(block.vtx.size());
+    for (uint32_t i{}; i < block.vtx.size(); i++) {
+        txContexts.emplace_back(view, *block.vtx[i], blockCtx, i);
+    }
+    ParallelFor(txContexts.size(), CUSTOM_TX_DECODE_CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            if (!block.vtx[i]->IsCoinBase()) {
+                (void)txContexts[i].GetTxMessage();
+            }
+        }
+    });
+
+    // Resolve what the txs are going to read from the database while they are
+    // applied one by one below
+    if (DfTxTaskPool && pcustomcsDB) {
+        for (size_t begin{}; begin < txContexts.size(); begin += CUSTOM_TX_PREFETCH_CHUNK_SIZE) {
+            CCustomTxReadHints hints;
+            const auto end = std::min(begin + CUSTOM_TX_PREFETCH_CHUNK_SIZE, txContexts.size());
+            for (auto i = begin; i < end; ++i) {
+                const auto &[res, txMessage] = txContexts[i].GetTxMessage();
+                if (block.vtx[i]->IsCoinBase() || !res) {
+                    continue;
+                }
+                auto txHints = GetCustomTxReadHints(txMessage);
+                hints.Merge(txHints);
+            }
+            if (hints.Empty()) {
+                continue;
+            }
+            DfTxTaskPool->Post(prefetchTaskGroup,
+                               [hints = std::move(hints)] { PrefetchCustomTxReads(*pcustomcsDB, hints); });
+        }
+    }
 
     if (isEvmEnabledForBlock) {
         auto xvmRes = XVM::TryFrom(block.vtx[0]->vout[1].scriptPubKey);
@@ -3049,27 +3096,14 @@ bool CChainState::ConnectBlock(const CBlock &block,
         auto isEccPreCacheEnabled = eccPreCacheControl == -1 || eccPreCacheControl > 0;
         if (isEccPreCacheEnabled) {
             // Pre-warm validation cache
-            auto &pool = DfTxTaskPool->pool;
-
             auto isFirstTx = true;
             for (uint32_t i{}; i < block.vtx.size(); i++) {
-                const auto &tx = *(block.vtx[i]);
-
-                if (tx.IsCoinBase()) {
+                if (block.vtx[i]->IsCoinBase()) {
                     continue;
                 }
 
-                auto txCtx = TransactionContext{
-                    view,
-                    tx,
-                    blockCtx,
-                    static_cast<uint32_t>(i),
-                };
-
-                const auto txType = txCtx.GetTxType();
-                txContexts.emplace(i, txCtx);
-
-                if (txType == CustomTxType::EvmTx) {
+                auto &txCtx = txContexts[i];
+                if (txCtx.GetTxType() == CustomTxType::EvmTx) {
                     if (isFirstTx) {
                         // Minor optimization: We skip the first one, since in most scenarios
                         // it will result in a single duplicated computation of the first cache
@@ -3080,29 +3114,33 @@ bool CChainState::ConnectBlock(const CBlock &block,
                         continue;
                     }
 
-                    auto &[r, txMessage] = txCtx.GetTxMessage();
+                    const auto &[r, txMessage] = txCtx.GetTxMessage();
                     if (!r) {
                         continue;
                     }
 
-                    evmEccPreCacheTaskPool.AddTask();
-                    boost::asio::post(pool, [&evmEccPreCacheTaskPool, evmMsg = std::move(txMessage)] {
-                        if (!evmEccPreCacheTaskPool.IsCancelled()) {
-                            const auto obj = std::get<CEvmTxMessage>(evmMsg);
-
-                            const auto rawEvmTx = HexStr(obj.evmTx);
-                            auto v = XResultValueLogged(evm_try_unsafe_make_signed_tx(result, rawEvmTx));
-                            if (v) {
-                                XResultStatusLogged(evm_try_unsafe_cache_signed_tx(result, rawEvmTx, *v));
-                            }
+                    DfTxTaskPool->Post(evmEccPreCacheTaskPool, [evmTx = std::get<CEvmTxMessage>(txMessage).evmTx] {
+                        const auto rawEvmTx = HexStr(evmTx);
+                        auto v = XResultValueLogged(evm_try_unsafe_make_signed_tx(result, rawEvmTx));
+                        if (v) {
+                            XResultStatusLogged(evm_try_unsafe_cache_signed_tx(result, rawEvmTx, *v));
                         }
-                        evmEccPreCacheTaskPool.RemoveTask();
                     });
                 }
             }
         }
     }
 
+    // Run the account and pool txs ahead, the loop below commits them
+    // in block order or applies them again when they conflict
+    CSpeculativeCustomTxs speculativeTxs(g_parallel_custom_tx_mode, accountsView);
+    for (auto &txCtx : txContexts) {
+        speculativeTxs.Add(blockCtx, txCtx);
+    }
+    CProcessStageTimer stageTimer;
+    speculativeTxs.Execute();
+    stageTimer.Lap("speculativetxs");
+
     // Execute TXs
     for (unsigned int i = 0; i < block.vtx.size(); i++) {
         const CTransaction &tx = *(block.vtx[i]);
@@ -3188,14 +3226,8 @@ bool CChainState::ConnectBlock(const CBlock &block,
 
             const auto applyCustomTxTime = GetTimeMicros();
 
-            auto txCtx = txContexts.count(i) ? txContexts.at(i)
-                                             : TransactionContext{
-                                                   view,
-                                                   tx,
-                                                   blockCtx,
-                                                   static_cast<uint32_t>(i),
-                                               };
-            const auto res = ApplyCustomTx(blockCtx, txCtx);
+            auto &txCtx = txContexts[i];
+            const auto res = speculativeTxs.Apply(i);
 
             LogApplyCustomTx(txCtx, applyCustomTxTime);
             if (!res.ok && (res.code & CustomTxErrCodes::Fatal)) {
@@ -3306,6 +3338,7 @@ bool CChainState::ConnectBlock(const CBlock &block,
              nInputs <= 1 ? 0 : MILLI * (nTime3 - nTime2) / (nInputs - 1),
              nTimeConnect * MICRO,
              nTimeConnect * MILLI / nBlocksTotal);
+    speculativeTxs.LogStats(strprintf("block %d", pindex->nHeight));
 
     // check main coinbase
     Res res = ApplyGeneralCoinbaseTx(accountsView, *block.vtx[0], pindex->nHeight, nFees, consensus);
@@ -3432,8 +3465,8 @@ bool CChainState::ConnectBlock(const CBlock &block,
         });
         if (pruneStarted) {
             auto &map = pruned.GetStorage().GetRaw();
-            compactBegin = map.begin()->first;
-            compactEnd = map.rbegin()->first;
+            compactBegin = FromKeyBytes(map.begin()->first);
+            compactEnd = FromKeyBytes(map.rbegin()->first);
             pruned.Flush();
             LogPrintf("Pruning undo data finished.\n");
             LogPrint(BCLog::BENCH, "    - Pruning undo data takes: %dms\n", GetTimeMillis() - time);
@@ -3474,6 +3507,14 @@ bool CChainState::ConnectBlock(const CBlock &block,
              nTimeCallbacks * MICRO,
              nTimeCallbacks * MILLI / nBlocksTotal);
 
+    const auto cacheHits = decodedCacheStats.hits.load(std::memory_order_relaxed);
+    const auto cacheMisses = decodedCacheStats.misses.load(std::memory_order_relaxed);
+    LogPrint(BCLog::BENCH,
+             "    - Decoded view cache: %u hits, %u misses [%.2f%% hit rate]\n",
+             cacheHits,
+             cacheMisses,
+             cacheHits + cacheMisses ? 100.0 * cacheHits / (cacheHits + cacheMisses) : 0.0);
+
     return true;
 }
 
@@ -3804,8 +3845,6 @@ bool CChainState::DisconnectTip(CValidationState &state,
 
     UpdateTip(pindexDelete->pprev, chainparams);
 
-    SetLastValidatedHeight(pindexDelete->pprev->nHeight);
-
     // DisconnectTip might be called before psnapshotManager has been initialised
     // as part of start-up so check psnapshotManager before using it.
     if (psnapshotManager) {
@@ -3816,6 +3855,8 @@ bool CChainState::DisconnectTip(CValidationState &state,
                                             BlockchainNearTip(pindexDelete->pprev->GetBlockTime()));
     }
 
+    SetLastValidatedHeight(pindexDelete->pprev->nHeight);
+
     // Let wallets know transactions went from 1-confirmed to
     // 0-confirmed or conflicted:
     GetMainSignals().BlockDisconnected(pblock);
@@ -3929,6 +3970,8 @@ bool CChainState::ConnectTip(CValidationState &state,
              "  - Load block from disk: %.2fms [%.2fs]\n",
              (nTime2 - nTime1) * MILLI,
              nTimeReadFromDisk * MICRO);
+    // State changed by the block, to invalidate cached RPC results depending on it
+    uint32_t changedCacheDeps{RPCCacheDeps::Block};
     {
         CCoinsViewCache view(&CoinsTip());
         CCustomCSView mnview(*pcustomcsview, paccountHistoryDB.get(), pburnHistoryDB.get(), pvaultHistoryDB.get());
@@ -3940,6 +3983,7 @@ bool CChainState::ConnectTip(CValidationState &state,
             return error("ConnectBlock %s failed, %s", p->GetBlockHash().ToString(), FormatStateMessage(s));
         };
 
+        deFiProcessStats.BeginBlock(pindexNew->nHeight, pindexNew->GetBlockHash());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, mnview, chainparams, rewardedAnchors, false);
         GetMainSignals().BlockChecked(blockConnecting, state);
         if (!rv) {
@@ -3954,9 +3998,22 @@ bool CChainState::ConnectTip(CValidationState &state,
                  nTimeConnectTotal * MICRO,
                  nTimeConnectTotal * MILLI / nBlocksTotal);
 
+        uint64_t keysWritten{}, bytesWritten{};
+        const auto collectStats = deFiProcessStats.IsActive();
+        for (const auto &[key, value] : mnview.GetStorage().GetRaw()) {
+            if (!key.empty()) {
+                changedCacheDeps |= GetRPCCacheDeps(key[0]);
+            }
+            if (collectStats) {
+                ++keysWritten;
+                bytesWritten += key.size() + (value ? value->size() : 0);
+            }
+        }
+
         bool flushed = view.Flush() && mnview.Flush();
         assert(flushed);
         mnview.GetHistoryWriters().FlushDB();
+        deFiProcessStats.EndBlock(keysWritten, bytesWritten);
 
         // Delete all other confirms from memory
         if (rewardedAnchors) {
@@ -4010,8 +4067,6 @@ bool CChainState::ConnectTip(CValidationState &state,
         }
     }
 
-    SetLastValidatedHeight(pindexNew->nHeight);
-
     // ConnectTip might be called before psnapshotManager has been initialised
     // as part of start-up so check psnapshotManager before using it.
     if (psnapshotManager) {
@@ -4022,6 +4077,9 @@ bool CChainState::ConnectTip(CValidationState &state,
                                             BlockchainNearTip(pindexNew->GetBlockTime()));
     }
 
+    // After the snapshots, so that results are not rebuilt from the previous block
+    SetLastValidatedHeight(pindexNew->nHeight, changedCacheDeps);
+
     int64_t nTime6 = GetTimeMicros();
     nTimePostConnect += nTime6 - nTime5;
     nTimeTotal += nTime6 - nTime1;
@@ -5362,6 +5420,8 @@ bool ProcessNewBlockHeaders(const std::vector<CBlockHeader> &headers,
     if (first_invalid != nullptr) {
         first_invalid->SetNull();
     }
+    // Signatures only depend on the headers, recover them before taking cs_main
+    pos::RecoverHeaderSignatures(headers);
     {
         LOCK(cs_main);
 
@@ -10,6 +10,7 @@ import time
 from test_framework.test_framework import DefiTestFramework
 from test_framework.util import (
     assert_equal,
+    assert_raises_rpc_error,
 )
 from test_framework.authproxy import JSONRPCException
 
@@ -33,6 +34,7 @@ class RPCstats(DefiTestFramework):
                 "-bayfrontheight=50",
                 "-bayfrontgardensheight=50",
                 "-rpcstats=0",
+                "-defiprocessstats=0",
             ],
         ]
 
@@ -53,6 +55,7 @@ class RPCstats(DefiTestFramework):
         getrpcstats = self.nodes[0].getrpcstats("listunspent")
         assert_equal(getrpcstats["name"], "listunspent")
         assert_equal(getrpcstats["count"], 2)
+        assert_equal(getrpcstats["failed"], 0)
 
         # test history's circular buffer of 5 elements
         [historyEntry1, historyEntry2] = getrpcstats["history"]
@@ -83,6 +86,30 @@ class RPCstats(DefiTestFramework):
             errorString = e.error["message"]
         assert "Rpcstats is desactivated." in errorString
 
+        # DeFi process stats of the last 100 connected blocks
+        processstats = self.nodes[0].getdefiprocessstats()
+        assert_equal(len(processstats["blocks"]), 100)
+        assert_equal(processstats["blocks"][-1]["height"], 101)
+        assert_equal(
+            processstats["blocks"][-1]["hash"], self.nodes[0].getblockhash(101)
+        )
+        assert "rewards" in processstats["blocks"][-1]["stages"]
+        assert processstats["stages"]["rewards"]["count"] >= 101
+
+        processstats = self.nodes[0].getdefiprocessstats(2)
+        assert_equal(
+            [block["height"] for block in processstats["blocks"]], [100, 101]
+        )
+        assert_raises_rpc_error(
+            -8, "blocks must be positive", self.nodes[0].getdefiprocessstats, 0
+        )
+
+        try:
+            self.nodes[1].getdefiprocessstats()
+        except JSONRPCException as e:
+            errorString = e.error["message"]
+        assert "DeFi process stats are disabled" in errorString
+
 
 if __name__ == "__main__":
     RPCstats().main()